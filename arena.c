@@ -0,0 +1,96 @@
+#include "arena.h"
+
+// Bytes taken by a block before its memory, kept aligned.
+#define ARENA_HEADER_SIZE ((sizeof(ArenaBlock) + ARENA_ALIGN - 1) & \
+        ~(size_t) (ARENA_ALIGN - 1))
+
+// Bytes held in blocks by every arena, for reporting memory use.
+static size_t heldBytes = 0;
+
+/**
+ * Sets up an empty arena. No memory is allocated until it is first used.
+ * @param arena - The arena to setup.
+ * @param blockSize - The amount of bytes in each block.
+ */
+void arena_init(Arena *arena, size_t blockSize) {
+    arena->blockSize = blockSize;
+    arena->used = 0;
+    arena->blocks = NULL;
+}
+
+/**
+ * Allocates memory from an arena, adding a block if the newest is full.
+ * @param arena - The arena to allocate from.
+ * @param size - The amount of bytes wanted.
+ * @return the memory, which lasts until the arena is reset or freed.
+ */
+void *arena_alloc(Arena *arena, size_t size) {
+    size = (size + ARENA_ALIGN - 1) & ~(size_t) (ARENA_ALIGN - 1);
+    ArenaBlock *block = arena->blocks;
+    if (block == NULL || block->used + size > block->size) {
+        size_t blockSize = size > arena->blockSize ? size : arena->blockSize;
+        block = malloc(ARENA_HEADER_SIZE + blockSize);
+        block->next = arena->blocks;
+        block->size = blockSize;
+        block->used = 0;
+        arena->blocks = block;
+        __atomic_fetch_add(&heldBytes, blockSize, __ATOMIC_RELAXED);
+    }
+    void *memory = (char *) block + ARENA_HEADER_SIZE + block->used;
+    block->used += size;
+    arena->used += size;
+    return memory;
+}
+
+/**
+ * Copies a string in to an arena.
+ * @param arena - The arena to copy in to.
+ * @param text - The string to copy.
+ * @return the copy.
+ */
+char *arena_copy_string(Arena *arena, const char *text) {
+    char *copy = arena_alloc(arena, sizeof(char) * (strlen(text) + 1));
+    strcpy(copy, text);
+    return copy;
+}
+
+/**
+ * Frees every allocation made from an arena in one go so it can be used
+ * again. A single block is kept, while an arena which needed more than one
+ * block frees them all and grows its block size to fit what was used.
+ * @param arena - The arena to reset.
+ */
+void arena_reset(Arena *arena) {
+    if (arena->blocks != NULL && arena->blocks->next == NULL) {
+        arena->blocks->used = 0;
+    } else {
+        if (arena->used > arena->blockSize) {
+            arena->blockSize = arena->used;
+        }
+        arena_free(arena);
+    }
+    arena->used = 0;
+}
+
+/**
+ * Frees every block of an arena, leaving it empty.
+ * @param arena - The arena to free.
+ */
+void arena_free(Arena *arena) {
+    while (arena->blocks != NULL) {
+        ArenaBlock *next = arena->blocks->next;
+        __atomic_fetch_sub(&heldBytes, arena->blocks->size, __ATOMIC_RELAXED);
+        free(arena->blocks);
+        arena->blocks = next;
+    }
+    arena->used = 0;
+}
+
+/**
+ * Gets the amount of memory held in blocks by every arena, whether or not
+ * it has been handed out. Safe to call from any thread.
+ * @return the amount of bytes.
+ */
+size_t arena_held_bytes(void) {
+    return __atomic_load_n(&heldBytes, __ATOMIC_RELAXED);
+}
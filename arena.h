@@ -0,0 +1,42 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include "shared.h"
+
+// Every allocation is aligned to this many bytes.
+#define ARENA_ALIGN 16
+
+/**
+ * Type defination for one block of memory handed out by an arena. The
+ * memory itself follows the block.
+ */
+typedef struct ArenaBlock {
+    struct ArenaBlock *next;
+    size_t size;
+    size_t used;
+} ArenaBlock;
+
+/**
+ * Type defination for a bump allocator. Memory is handed out from the
+ * newest block and is never freed on its own, only everything at once by
+ * arena_reset or arena_free. An arena which outgrew its block is given one
+ * large enough for everything after it is reset, so an arena reused for
+ * similar work settles on a single block and stops calling malloc.
+ */
+typedef struct {
+    size_t blockSize;
+    size_t used;
+    ArenaBlock *blocks;
+} Arena;
+
+/**
+ * Function prototypes.
+ */
+void arena_init(Arena *arena, size_t blockSize);
+void *arena_alloc(Arena *arena, size_t size);
+char *arena_copy_string(Arena *arena, const char *text);
+void arena_reset(Arena *arena);
+void arena_free(Arena *arena);
+size_t arena_held_bytes(void);
+
+#endif
@@ -0,0 +1,170 @@
+#include "decks.h"
+
+/**
+ * Creates a shared deck with a single reference.
+ * @param cards - The cards of the deck, which the deck takes ownership of.
+ * @param size - The number of cards.
+ * @return the deck.
+ */
+SharedDeck *shared_deck_create(struct Card *cards, int size) {
+    SharedDeck *deck = malloc(sizeof(SharedDeck));
+    deck->references = 1;
+    deck->size = size;
+    deck->cards = cards;
+    deck->mapping = NULL;
+    deck->mappingSize = 0;
+    return deck;
+}
+
+/**
+ * Takes a reference to a shared deck. Safe to call from any thread.
+ * @param deck - The deck.
+ * @return the deck.
+ */
+SharedDeck *shared_deck_acquire(SharedDeck *deck) {
+    __atomic_fetch_add(&deck->references, 1, __ATOMIC_RELAXED);
+    return deck;
+}
+
+/**
+ * Gives up a reference to a shared deck, freeing it if it was the last.
+ * Safe to call from any thread.
+ * @param deck - The deck.
+ */
+void shared_deck_release(SharedDeck *deck) {
+    if (__atomic_sub_fetch(&deck->references, 1, __ATOMIC_ACQ_REL) == 0) {
+        if (deck->mapping != NULL) {
+            munmap(deck->mapping, deck->mappingSize);
+        } else {
+            free(deck->cards);
+        }
+        free(deck);
+    }
+}
+
+/**
+ * Writes every byte of a buffer to a file.
+ * @param fd - The file.
+ * @param bytes - The bytes to write.
+ * @param length - The amount of bytes.
+ * @return 0 on success, -1 on failure.
+ */
+static int write_all(int fd, const void *bytes, size_t length) {
+    size_t written = 0;
+    while (written < length) {
+        ssize_t result = write(fd, (const char *) bytes + written,
+                length - written);
+        if (result == -1 && errno == EINTR) {
+            continue;
+        }
+        if (result == -1) {
+            return -1;
+        }
+        written += result;
+    }
+    return 0;
+}
+
+/**
+ * Compiles cards in to a deck image. The image is written beside the path
+ * and renamed over it once complete, so a server which has the old image
+ * mapped keeps reading the old cards.
+ * @param path - Where to write the image.
+ * @param cards - The cards of the deck.
+ * @param size - The number of cards.
+ * @return 0 on success, -1 on failure.
+ */
+int deck_image_write(char *path, struct Card *cards, int size) {
+    DeckImageHeader header;
+    memset(&header, 0, sizeof(header));
+    strcpy(header.magic, DECK_IMAGE_MAGIC);
+    header.version = DECK_IMAGE_VERSION;
+    header.cardSize = sizeof(struct Card);
+    header.cardCount = size;
+    char *temp = malloc(sizeof(char) * (strlen(path) + strlen(".tmp") + 1));
+    sprintf(temp, "%s.tmp", path);
+    int fd = open(temp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    int failed = fd == -1 ||
+            write_all(fd, &header, sizeof(header)) == -1 ||
+            write_all(fd, cards, sizeof(struct Card) * size) == -1 ||
+            fsync(fd) == -1;
+    if (fd != -1) {
+        failed = close(fd) == -1 || failed;
+    }
+    if (!failed) {
+        failed = rename(temp, path) == -1;
+    }
+    if (failed) {
+        unlink(temp);
+    }
+    free(temp);
+    return failed ? -1 : 0;
+}
+
+/**
+ * Loads a deck from a deck image by mapping it read only. Nothing is parsed
+ * or copied, so loading takes the same time however many cards there are.
+ * @param path - The path of the image.
+ * @param output - Set to a deck with a single reference.
+ * @return DECK_IMAGE_VALID on success, DECK_IMAGE_NOT_IMAGE if the file
+ * is not a deck image and DECK_IMAGE_INVALID if it is an image which cannot
+ * be used.
+ */
+enum DeckImageStatus deck_image_open(char *path, SharedDeck **output) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return DECK_IMAGE_NOT_IMAGE;
+    }
+    struct stat status;
+    DeckImageHeader header;
+    if (fstat(fd, &status) == -1 || status.st_size < sizeof(header) ||
+            pread(fd, &header, sizeof(header), 0) != sizeof(header) ||
+            memcmp(header.magic, DECK_IMAGE_MAGIC,
+            sizeof(DECK_IMAGE_MAGIC)) != 0) {
+        close(fd);
+        return DECK_IMAGE_NOT_IMAGE;
+    }
+    if (header.version != DECK_IMAGE_VERSION ||
+            header.cardSize != sizeof(struct Card) ||
+            header.cardCount == 0 || header.cardCount > INT_MAX ||
+            status.st_size != sizeof(header) +
+            (off_t) header.cardCount * sizeof(struct Card)) {
+        close(fd);
+        return DECK_IMAGE_INVALID;
+    }
+    void *mapping = mmap(NULL, status.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        return DECK_IMAGE_INVALID;
+    }
+    SharedDeck *deck = shared_deck_create((struct Card *)
+            ((char *) mapping + sizeof(header)), header.cardCount);
+    deck->mapping = mapping;
+    deck->mappingSize = status.st_size;
+    *output = deck;
+    return DECK_IMAGE_VALID;
+}
+
+/**
+ * Reads a deckfile in to a deck which games can share. The deckfile may
+ * be a deck image compiled by timon, which is mapped rather than parsed.
+ * @param path - The path of the deckfile.
+ * @returns The deck, NULL if the deckfile is invalid.
+ */
+SharedDeck *read_deckfile(char *path) {
+    SharedDeck *image;
+    switch (deck_image_open(path, &image)) {
+        case (DECK_IMAGE_VALID):
+            return image;
+        case (DECK_IMAGE_INVALID):
+            return NULL;
+        default:
+            break;
+    }
+    int deckSize;
+    struct Card *deck;
+    if (parse_deck_file(&deckSize, &deck, path) != VALID) {
+        return NULL;
+    }
+    return shared_deck_create(deck, deckSize);
+}
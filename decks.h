@@ -0,0 +1,61 @@
+#ifndef DECKS_H
+#define DECKS_H
+
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "shared.h"
+
+// Deck images start with this, null terminated, then the format version.
+#define DECK_IMAGE_MAGIC "RAFDECK"
+#define DECK_IMAGE_VERSION 1
+
+/**
+ * Enum for the result of opening a deck image.
+ */
+enum DeckImageStatus {
+    DECK_IMAGE_VALID,
+    DECK_IMAGE_NOT_IMAGE,
+    DECK_IMAGE_INVALID,
+};
+
+/**
+ * Type defination for the header of a deck image, a deckfile compiled in to
+ * the cards exactly as they are laid out in memory. The cards follow the
+ * header directly. Images are only read by builds which agree on the
+ * version and the size of a card.
+ */
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t cardSize;
+    uint32_t cardCount;
+    uint32_t padding;
+} DeckImageHeader;
+
+/**
+ * Type defination for a deck which is never modified once loaded, so any
+ * number of games can draw from it at once. Each game keeps its own cursor
+ * in to the cards and holds a reference until it ends. A deck loaded from
+ * an image reads its cards straight from the mapping, which every process
+ * mapping the same image shares.
+ */
+typedef struct {
+    int references;
+    int size;
+    struct Card *cards;
+    void *mapping;
+    size_t mappingSize;
+} SharedDeck;
+
+/**
+ * Function prototypes.
+ */
+SharedDeck *shared_deck_create(struct Card *cards, int size);
+SharedDeck *shared_deck_acquire(SharedDeck *deck);
+void shared_deck_release(SharedDeck *deck);
+int deck_image_write(char *path, struct Card *cards, int size);
+enum DeckImageStatus deck_image_open(char *path, SharedDeck **output);
+SharedDeck *read_deckfile(char *path);
+
+#endif
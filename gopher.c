@@ -7,7 +7,7 @@
 void exit_with_error(int error) {
     switch(error) {
         case INVALID_ARG_NUM:
-            fprintf(stderr, "Usage: gopher port\n");
+            fprintf(stderr, "Usage: gopher [-l] port\n");
             break;
         case CONNECT_ERR_SCORE:
             fprintf(stderr, "Failed to connect\n");
@@ -23,17 +23,22 @@ void exit_with_error(int error) {
  * Checks initial arguments for gopher.
  * @param argc - Argument count.
  * @param argv - Argument vector.
+ * @returns The port, which follows the latency flag if it was given.
  */
-void check_args(int argc, char **argv) {
-    if (argc != EXPECTED_ARGC) {
+char *check_args(int argc, char **argv) {
+    int flagged = argc == EXPECTED_ARGC + 1 &&
+            strcmp(argv[PORT], LATENCY_FLAG) == 0;
+    if (argc != EXPECTED_ARGC && !flagged) {
         exit_with_error(INVALID_ARG_NUM);
     }
-    if (!is_string_digit(argv[PORT])) {
+    char *port = argv[PORT + flagged];
+    if (!is_string_digit(port)) {
         exit_with_error(CONNECT_ERR_SCORE);
     }
-    if (atoi(argv[PORT]) < 0 || atoi(argv[PORT]) > 65535) {
+    if (atoi(port) < 0 || atoi(port) > 65535) {
         exit_with_error(CONNECT_ERR_SCORE);
     }
+    return port;
 }
 
 /**
@@ -82,44 +87,31 @@ enum Error get_socket(int *output, char *port) {
  * Main
  */
 int main(int argc, char **argv) {
-    check_args(argc, argv);
+    char *port = check_args(argc, argv);
+    int latency = port != argv[PORT];
     int sock;
-    enum Error error = get_socket(&sock, argv[PORT]);
+    enum Error error = get_socket(&sock, port);
     if (error) {
         exit_with_error(CONNECT_ERR_SCORE);
     }
     FILE *toServer = fdopen(sock, "w");
-    FILE *fromServer = fdopen(sock, "r");
-    send_message(toServer, "scores\n");
+    LineReader fromServer;
+    line_reader_init(&fromServer, sock);
+    send_message(toServer, latency ? "latency\n" : "scores\n");
     char *buffer;
-    if (feof(fromServer)) { // Server closed.
+    int bytesRead = line_reader_read(&fromServer, &buffer);
+    if (bytesRead <= 0) { // Server closed or no bytes read.
         fclose(toServer);
-        fclose(fromServer);
-        exit_with_error(INVALID_SERVER);
-    }
-    int bytesRead = read_line(fromServer, &buffer, 0);
-    if (bytesRead == 0) { // No bytes read.
-        free(buffer);
-        fclose(toServer);
-        fclose(fromServer);
         exit_with_error(INVALID_SERVER);
     }
     if (!(strcmp(buffer, "yes") == 0)) { // Server did not respond with yes.
-        free(buffer);
         fclose(toServer);
-        fclose(fromServer);
         exit_with_error(INVALID_SERVER);
     }
-    free(buffer);
     char *scores;
-    while (1) { // Read stream and print to stdout.
-        read_line(fromServer, &scores, 0);
-        if (feof(fromServer)) {
-            break;
-        }
+    while (line_reader_read(&fromServer, &scores) != -1) {
+        // Read stream and print to stdout.
         printf("%s\n", scores);
-        free(scores);
     }
     fclose(toServer);
-    fclose(fromServer);
 }
\ No newline at end of file
@@ -4,6 +4,8 @@
 #include "shared.h"
 
 #define EXPECTED_ARGC 2
+// Asks for the latencies of each port rather than the scores.
+#define LATENCY_FLAG "-l"
 
 /**
  * Enum for gopher arguments
@@ -16,6 +18,6 @@ enum Argument {
  * Function prototypes
  */
 void exit_with_error(int error);
-void check_args(int argc, char **argv);
+char *check_args(int argc, char **argv);
 enum Error get_socket(int *output, char *port);
 #endif
\ No newline at end of file
@@ -0,0 +1,110 @@
+#include "shared.h"
+#include "intern.h"
+
+/**
+ * Sets up an empty intern table.
+ * @param table - The table to setup.
+ */
+void intern_table_init(InternTable *table) {
+    table->nextId = 0;
+    for (int i = 0; i < INTERN_STRIPES; i++) {
+        InternStripe *stripe = &table->stripes[i];
+        pthread_mutex_init(&stripe->lock, NULL);
+        stripe->entryCount = 0;
+        stripe->capacity = 0;
+        stripe->slots = NULL;
+    }
+}
+
+/**
+ * Frees an intern table and every name in it. Nothing may still be using
+ * the names.
+ * @param table - The table to free.
+ */
+void intern_table_free(InternTable *table) {
+    for (int i = 0; i < INTERN_STRIPES; i++) {
+        InternStripe *stripe = &table->stripes[i];
+        for (int j = 0; j < stripe->capacity; j++) {
+            free(stripe->slots[j]);
+        }
+        pthread_mutex_destroy(&stripe->lock);
+        free(stripe->slots);
+    }
+}
+
+/**
+ * Finds the slot of a name in a stripe, or the empty slot where the name
+ * would go. The stripe must have at least one empty slot.
+ * @param stripe - The stripe to search.
+ * @param name - The name.
+ * @param hash - The hash of the name.
+ * @return the slot.
+ */
+static InternedName **find_slot(InternStripe *stripe, char *name,
+        unsigned int hash) {
+    // The low bits chose the stripe, so probe with the rest.
+    int mask = stripe->capacity - 1;
+    int index = (hash / INTERN_STRIPES) & mask;
+    while (stripe->slots[index] != NULL && (stripe->slots[index]->hash !=
+            hash || strcmp(stripe->slots[index]->name, name) != 0)) {
+        index = (index + 1) & mask;
+    }
+    return &stripe->slots[index];
+}
+
+/**
+ * Doubles the capacity of a stripe, keeping it at most half full.
+ * @param stripe - The stripe to grow.
+ */
+static void grow_stripe(InternStripe *stripe) {
+    InternedName **old = stripe->slots;
+    int oldCapacity = stripe->capacity;
+    stripe->capacity = oldCapacity == 0 ? INTERN_MIN_CAPACITY :
+            oldCapacity * 2;
+    stripe->slots = calloc(stripe->capacity, sizeof(InternedName *));
+    for (int i = 0; i < oldCapacity; i++) {
+        if (old[i] != NULL) {
+            *find_slot(stripe, old[i]->name, old[i]->hash) = old[i];
+        }
+    }
+    free(old);
+}
+
+/**
+ * Gets the canonical entry of a player name, giving the name the next ID
+ * if it has not been seen before. Safe to call from any thread.
+ * @param table - The table to intern in.
+ * @param name - The name, which is copied.
+ * @return the entry, which lasts as long as the table.
+ */
+InternedName *intern_name(InternTable *table, char *name) {
+    unsigned int hash = hash_name(name);
+    InternStripe *stripe = &table->stripes[hash % INTERN_STRIPES];
+    pthread_mutex_lock(&stripe->lock);
+    if ((stripe->entryCount + 1) * 2 > stripe->capacity) {
+        grow_stripe(stripe);
+    }
+    InternedName **slot = find_slot(stripe, name, hash);
+    if (*slot == NULL) {
+        InternedName *entry = malloc(sizeof(InternedName) +
+                sizeof(char) * (strlen(name) + 1));
+        entry->id = __atomic_fetch_add(&table->nextId, 1, __ATOMIC_RELAXED);
+        entry->hash = hash;
+        strcpy(entry->name, name);
+        *slot = entry;
+        stripe->entryCount++;
+    }
+    InternedName *entry = *slot;
+    pthread_mutex_unlock(&stripe->lock);
+    return entry;
+}
+
+/**
+ * Gets the entry of a name which was returned by intern_name, such as a
+ * player's name in a game.
+ * @param name - The canonical string of the name.
+ * @return the entry.
+ */
+InternedName *interned_of(char *name) {
+    return (InternedName *) (name - offsetof(InternedName, name));
+}
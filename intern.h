@@ -0,0 +1,52 @@
+#ifndef INTERN_H
+#define INTERN_H
+
+#include <stddef.h>
+#include <pthread.h>
+
+#define INTERN_STRIPES 16
+#define INTERN_MIN_CAPACITY 16
+
+/**
+ * Type defination for a player name held by an intern table. The name
+ * follows the entry in the same allocation, so the canonical string of a
+ * name leads straight back to its ID.
+ */
+typedef struct {
+    int id;
+    unsigned int hash;
+    char name[];
+} InternedName;
+
+/**
+ * Type defination for one stripe of an intern table. Each stripe is an open
+ * addressing hash map with its own lock.
+ */
+typedef struct {
+    pthread_mutex_t lock;
+    int entryCount;
+    int capacity;
+    InternedName **slots;
+} InternStripe;
+
+/**
+ * Type defination for a table giving every player name a small ID and one
+ * canonical copy of the name. Entries are never removed, so IDs and names
+ * stay valid for as long as the table lasts and can be compared by ID
+ * rather than with strcmp. Names are spread over the stripes by hash, so
+ * threads interning different names rarely wait on each other.
+ */
+typedef struct {
+    int nextId;
+    InternStripe stripes[INTERN_STRIPES];
+} InternTable;
+
+/**
+ * Function prototypes.
+ */
+void intern_table_init(InternTable *table);
+void intern_table_free(InternTable *table);
+InternedName *intern_name(InternTable *table, char *name);
+InternedName *interned_of(char *name);
+
+#endif
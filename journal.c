@@ -0,0 +1,117 @@
+#include "journal.h"
+
+/**
+ * Opens a journal file for appending.
+ * @param journal - The journal to setup.
+ * @param path - The path of the file, which is created if missing.
+ * @param truncate - 1 to throw away anything already in the file.
+ * @param sync - 1 to wait for each commit to reach the disk.
+ * @return 0 on success, -1 on failure.
+ */
+int journal_open(Journal *journal, char *path, int truncate, int sync) {
+    int flags = O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC;
+    if (truncate) {
+        flags |= O_TRUNC;
+    }
+    journal->fd = open(path, flags, 0644);
+    if (journal->fd == -1) {
+        return -1;
+    }
+    journal->sync = sync;
+    journal->length = 0;
+    journal->batch = malloc(JOURNAL_BATCH_SIZE + JOURNAL_RECORD_SIZE);
+    return 0;
+}
+
+/**
+ * Commits anything left in a journal and closes it.
+ * @param journal - The journal to close.
+ */
+void journal_close(Journal *journal) {
+    journal_commit(journal);
+    close(journal->fd);
+    free(journal->batch);
+}
+
+/**
+ * Adds a record to a journal's batch. The record is a line formatted like
+ * printf, and is not on disk until the batch is committed. A batch which
+ * has grown large is committed straight away.
+ * @param journal - The journal to add to.
+ * @param format - The format of the record, without a newline.
+ */
+void journal_record(Journal *journal, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(journal->batch + journal->length,
+            JOURNAL_RECORD_SIZE, format, args);
+    va_end(args);
+    if (length < 0 || length >= JOURNAL_RECORD_SIZE) {
+        // Records are never this long, keep the journal readable anyway.
+        return;
+    }
+    journal->length += length;
+    journal->batch[journal->length++] = '\n';
+    if (journal->length >= JOURNAL_BATCH_SIZE) {
+        journal_commit(journal);
+    }
+}
+
+/**
+ * Writes every record in a journal's batch to its file in one go, so every
+ * record made since the last commit is committed together.
+ * @param journal - The journal to commit.
+ * @return 0 on success, -1 if the records could not be written.
+ */
+int journal_commit(Journal *journal) {
+    if (journal->length == 0) {
+        return 0;
+    }
+    int written = 0;
+    while (written < journal->length) {
+        ssize_t result = write(journal->fd, journal->batch + written,
+                journal->length - written);
+        if (result == -1 && errno == EINTR) {
+            continue;
+        }
+        if (result == -1) {
+            journal->length = 0;
+            return -1;
+        }
+        written += result;
+    }
+    journal->length = 0;
+    if (journal->sync) {
+        return fdatasync(journal->fd);
+    }
+    return 0;
+}
+
+/**
+ * Reads back every whole record in a journal file, in the order they were
+ * written. A record cut short by a crash part way through a write is
+ * ignored.
+ * @param path - The path of the file.
+ * @param handler - Called with each record, without its newline.
+ * @param arg - Passed to the handler.
+ * @return 0 on success, -1 if the file could not be opened.
+ */
+int journal_read(char *path, JournalHandler handler, void *arg) {
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        return -1;
+    }
+    char *record = NULL;
+    size_t size = 0;
+    ssize_t length;
+    while ((length = getline(&record, &size, file)) != -1) {
+        if (record[length - 1] != '\n') {
+            break;
+        }
+        record[length - 1] = '\0';
+        handler(arg, record);
+    }
+    free(record);
+    fclose(file);
+    return 0;
+}
@@ -0,0 +1,40 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include "shared.h"
+
+// Records are committed early once a batch grows this large.
+#define JOURNAL_BATCH_SIZE 65536
+// Large enough for any record, which holds at most one line from a player.
+#define JOURNAL_RECORD_SIZE (2 * LINE_READER_SIZE)
+
+/**
+ * Type defination for an append-only journal file. Records are gathered in
+ * the batch and written together by journal_commit, so a busy thread pays
+ * for one write however many records it made. A journal is only ever
+ * written by the thread which owns it.
+ */
+typedef struct {
+    int fd;
+    int sync;
+    int length;
+    char *batch;
+} Journal;
+
+/**
+ * Callback for each record read back from a journal.
+ */
+typedef void (*JournalHandler)(void *arg, char *record);
+
+/**
+ * Function prototypes.
+ */
+int journal_open(Journal *journal, char *path, int truncate, int sync);
+void journal_close(Journal *journal);
+void journal_record(Journal *journal, const char *format, ...);
+int journal_commit(Journal *journal);
+int journal_read(char *path, JournalHandler handler, void *arg);
+
+#endif
@@ -0,0 +1,101 @@
+#include <time.h>
+#include "latency.h"
+
+/**
+ * Gets the current time from a monotonic clock.
+ * @return the amount of microseconds since an arbitrary point.
+ */
+uint64_t latency_now(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+/**
+ * Gets the bucket a value is counted in. Values below HISTOGRAM_SUB_BUCKETS
+ * have a bucket each, above that each power of two is split evenly.
+ * @param value - The value.
+ * @return the index of the bucket.
+ */
+static int get_bucket(uint64_t value) {
+    if (value < HISTOGRAM_SUB_BUCKETS) {
+        return (int) value;
+    }
+    int exponent = 63 - __builtin_clzll(value);
+    if (exponent >= HISTOGRAM_MAX_BITS) {
+        return HISTOGRAM_BUCKETS - 1;
+    }
+    int sub = (value >> (exponent - HISTOGRAM_SUB_BITS)) &
+            (HISTOGRAM_SUB_BUCKETS - 1);
+    return (exponent - HISTOGRAM_SUB_BITS + 1) * HISTOGRAM_SUB_BUCKETS + sub;
+}
+
+/**
+ * Gets the highest value counted in a bucket.
+ * @param bucket - The index of the bucket.
+ * @return the value.
+ */
+static uint64_t get_bucket_value(int bucket) {
+    if (bucket < HISTOGRAM_SUB_BUCKETS) {
+        return bucket;
+    }
+    int shift = bucket / HISTOGRAM_SUB_BUCKETS - 1;
+    uint64_t lowest = (uint64_t) (HISTOGRAM_SUB_BUCKETS +
+            bucket % HISTOGRAM_SUB_BUCKETS) << shift;
+    return lowest + ((uint64_t) 1 << shift) - 1;
+}
+
+/**
+ * Counts a value in a histogram. Must only be called by the thread which
+ * owns the histogram.
+ * @param histogram - The histogram to record in.
+ * @param value - The value, in microseconds.
+ */
+void histogram_record(Histogram *histogram, uint64_t value) {
+    uint64_t *count = &histogram->counts[get_bucket(value)];
+    // Only the owner writes, so a plain increment published atomically is
+    // enough for readers to never see a torn count.
+    __atomic_store_n(count, *count + 1, __ATOMIC_RELAXED);
+}
+
+/**
+ * Adds the counts of one histogram to another. Safe to call while the
+ * owner of the histogram being merged is still recording in it.
+ * @param into - The histogram to add to, owned by the caller.
+ * @param from - The histogram to add.
+ */
+void histogram_merge(Histogram *into, Histogram *from) {
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        into->counts[i] += __atomic_load_n(&from->counts[i],
+                __ATOMIC_RELAXED);
+    }
+}
+
+/**
+ * Gets the value which a given fraction of the values in a histogram are
+ * at or below.
+ * @param histogram - The histogram.
+ * @param percentile - The fraction, such as 0.99.
+ * @return the value, 0 if nothing has been recorded.
+ */
+uint64_t histogram_percentile(Histogram *histogram, double percentile) {
+    uint64_t total = 0;
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        total += histogram->counts[i];
+    }
+    if (total == 0) {
+        return 0;
+    }
+    uint64_t wanted = (uint64_t) (percentile * total + 0.5);
+    if (wanted == 0) {
+        wanted = 1;
+    }
+    uint64_t seen = 0;
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        seen += histogram->counts[i];
+        if (seen >= wanted) {
+            return get_bucket_value(i);
+        }
+    }
+    return get_bucket_value(HISTOGRAM_BUCKETS - 1);
+}
@@ -0,0 +1,35 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <stdint.h>
+
+// Each power of two is split in to this many buckets, so a recorded value
+// is reported to within 1 / HISTOGRAM_SUB_BUCKETS of what it was.
+#define HISTOGRAM_SUB_BITS 4
+#define HISTOGRAM_SUB_BUCKETS (1 << HISTOGRAM_SUB_BITS)
+// Values of 2 ^ HISTOGRAM_MAX_BITS microseconds or more, over an hour, are
+// counted in the last bucket.
+#define HISTOGRAM_MAX_BITS 32
+#define HISTOGRAM_BUCKETS ((HISTOGRAM_MAX_BITS - HISTOGRAM_SUB_BITS + 1) * \
+        HISTOGRAM_SUB_BUCKETS)
+
+/**
+ * Type defination for a histogram of latencies in microseconds. Buckets
+ * grow with the value, so small and large values are both kept to the same
+ * relative precision in a fixed amount of memory. A histogram is only ever
+ * recorded in by one thread, so recording needs no lock or atomic add, and
+ * other threads merge it with atomic reads when they want a percentile.
+ */
+typedef struct {
+    uint64_t counts[HISTOGRAM_BUCKETS];
+} Histogram;
+
+/**
+ * Function prototypes.
+ */
+uint64_t latency_now(void);
+void histogram_record(Histogram *histogram, uint64_t value);
+void histogram_merge(Histogram *into, Histogram *from);
+uint64_t histogram_percentile(Histogram *histogram, double percentile);
+
+#endif
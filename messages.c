@@ -0,0 +1,245 @@
+#include "messages.h"
+
+/**
+ * Copies a string in to a message.
+ * @param out - Where to write.
+ * @param string - The string to copy, without its null terminator.
+ * @return the position after the string.
+ */
+static char *put_string(char *out, const char *string) {
+    while (*string != '\0') {
+        *out++ = *string++;
+    }
+    return out;
+}
+
+/**
+ * Writes an integer in decimal in to a message.
+ * @param out - Where to write.
+ * @param value - The integer to write.
+ * @return the position after the integer.
+ */
+static char *put_int(char *out, int value) {
+    char digits[12];
+    int count = 0;
+    unsigned int magnitude = value < 0 ? -(unsigned int) value : value;
+    do {
+        digits[count++] = '0' + magnitude % 10;
+        magnitude /= 10;
+    } while (magnitude > 0);
+    if (value < 0) {
+        *out++ = '-';
+    }
+    while (count > 0) {
+        *out++ = digits[--count];
+    }
+    return out;
+}
+
+/**
+ * Writes a list of integers seperated by commas in to a message.
+ * @param out - Where to write.
+ * @param values - The integers to write.
+ * @param count - The number of integers.
+ * @return the position after the list.
+ */
+static char *put_list(char *out, const int *values, int count) {
+    for (int i = 0; i < count; i++) {
+        if (i > 0) {
+            *out++ = ',';
+        }
+        out = put_int(out, values[i]);
+    }
+    return out;
+}
+
+/**
+ * Terminates a message with a newline and a null terminator.
+ * @param buffer - The start of the message.
+ * @param out - The end of the message.
+ * @return the length of the message, including the newline.
+ */
+static int end_message(char *buffer, char *out) {
+    *out++ = '\n';
+    *out = '\0';
+    return out - buffer;
+}
+
+/**
+ * Formats a message telling players a card was purchased.
+ * @param buffer - Where to write, at least MESSAGE_BUFFER_SIZE long.
+ * @param playerId - The ID of the purchasing player.
+ * @param message - The purchase made.
+ * @return the length of the message.
+ */
+int format_purchased(char *buffer, int playerId,
+        struct PurchaseMessage message) {
+    char *out = put_string(buffer, "purchased");
+    *out++ = 'A' + playerId;
+    *out++ = ':';
+    out = put_int(out, message.cardNumber);
+    *out++ = ':';
+    out = put_list(out, message.costSpent, TOKEN_MAX);
+    return end_message(buffer, out);
+}
+
+/**
+ * Formats a message telling players tokens were taken.
+ * @param buffer - Where to write, at least MESSAGE_BUFFER_SIZE long.
+ * @param playerId - The ID of the player taking tokens.
+ * @param message - The tokens taken.
+ * @return the length of the message.
+ */
+int format_took(char *buffer, int playerId, struct TakeMessage message) {
+    char *out = put_string(buffer, "took");
+    *out++ = 'A' + playerId;
+    *out++ = ':';
+    out = put_list(out, message.tokens, TOKEN_MAX - 1);
+    return end_message(buffer, out);
+}
+
+/**
+ * Formats a message telling players a wild token was taken.
+ * @param buffer - Where to write, at least MESSAGE_BUFFER_SIZE long.
+ * @param playerId - The ID of the player taking the token.
+ * @return the length of the message.
+ */
+int format_wild(char *buffer, int playerId) {
+    char *out = put_string(buffer, "wild");
+    *out++ = 'A' + playerId;
+    return end_message(buffer, out);
+}
+
+/**
+ * Formats a message telling players a card was added to the board.
+ * @param buffer - Where to write, at least MESSAGE_BUFFER_SIZE long.
+ * @param card - The new card.
+ * @return the length of the message.
+ */
+int format_new_card(char *buffer, struct Card card) {
+    char *out = put_string(buffer, "newcard");
+    *out++ = print_token(card.discount);
+    *out++ = ':';
+    out = put_int(out, card.points);
+    *out++ = ':';
+    out = put_list(out, card.cost, TOKEN_MAX - 1);
+    return end_message(buffer, out);
+}
+
+/**
+ * Formats a message telling players the game ended as a player left.
+ * @param buffer - Where to write, at least MESSAGE_BUFFER_SIZE long.
+ * @param playerId - The ID of the player who left.
+ * @return the length of the message.
+ */
+int format_disco(char *buffer, int playerId) {
+    char *out = put_string(buffer, "disco");
+    *out++ = 'A' + playerId;
+    return end_message(buffer, out);
+}
+
+/**
+ * Formats a message telling players the game ended on an invalid move.
+ * @param buffer - Where to write, at least MESSAGE_BUFFER_SIZE long.
+ * @param playerId - The ID of the player who made the move.
+ * @return the length of the message.
+ */
+int format_invalid(char *buffer, int playerId) {
+    char *out = put_string(buffer, "invalid");
+    *out++ = 'A' + playerId;
+    return end_message(buffer, out);
+}
+
+/**
+ * Formats a message telling players how many tokens each pile starts with.
+ * @param buffer - Where to write, at least MESSAGE_BUFFER_SIZE long.
+ * @param tokens - The size of each pile.
+ * @return the length of the message.
+ */
+int format_tokens(char *buffer, int tokens) {
+    char *out = put_string(buffer, "tokens");
+    out = put_int(out, tokens);
+    return end_message(buffer, out);
+}
+
+/**
+ * Formats a message telling a player who they are in a game.
+ * @param buffer - Where to write, at least MESSAGE_BUFFER_SIZE long.
+ * @param playerId - The ID of the player.
+ * @param playerCount - The number of players in the game.
+ * @return the length of the message.
+ */
+int format_playinfo(char *buffer, int playerId, int playerCount) {
+    char *out = put_string(buffer, "playinfo");
+    *out++ = 'A' + playerId;
+    *out++ = '/';
+    out = put_int(out, playerCount);
+    return end_message(buffer, out);
+}
+
+/**
+ * Formats a message telling a player the ID they can reconnect with.
+ * @param buffer - Where to write.
+ * @param size - The size of the buffer.
+ * @param gameName - The name of the game.
+ * @param gameCounter - The number of games with the name so far.
+ * @param playerId - The ID of the player.
+ * @return the length of the message, -1 if it does not fit.
+ */
+int format_rid(char *buffer, int size, char *gameName, int gameCounter,
+        int playerId) {
+    // Room for the name, two ints, the seperators and terminators.
+    if (strlen(gameName) + 3 + 2 * 11 + 4 > size) {
+        return -1;
+    }
+    char *out = put_string(buffer, "rid");
+    out = put_string(out, gameName);
+    *out++ = ',';
+    out = put_int(out, gameCounter);
+    *out++ = ',';
+    out = put_int(out, playerId);
+    return end_message(buffer, out);
+}
+
+/**
+ * Formats a message holding the whole state of a game in one line: who the
+ * player is, the tokens left to take, the cards on the board and the score,
+ * discounts and tokens of every player. Sections are seperated by '|' and
+ * the cards and players within them by ';'.
+ * @param buffer - Where to write, at least SNAPSHOT_BUFFER_SIZE long.
+ * @param game - The game.
+ * @param playerId - The ID of the player the snapshot is for.
+ * @return the length of the message.
+ */
+int format_snapshot(char *buffer, struct Game *game, int playerId) {
+    char *out = put_string(buffer, "snapshot");
+    *out++ = 'A' + playerId;
+    *out++ = '/';
+    out = put_int(out, game->playerCount);
+    *out++ = '|';
+    out = put_list(out, game->tokenCount, TOKEN_MAX - 1);
+    *out++ = '|';
+    for (int i = 0; i < game->boardSize; i++) {
+        if (i > 0) {
+            *out++ = ';';
+        }
+        *out++ = print_token(game->board[i].discount);
+        *out++ = ':';
+        out = put_int(out, game->board[i].points);
+        *out++ = ':';
+        out = put_list(out, game->board[i].cost, TOKEN_MAX - 1);
+    }
+    *out++ = '|';
+    for (int i = 0; i < game->playerCount; i++) {
+        struct Player *player = &game->players[i].state;
+        if (i > 0) {
+            *out++ = ';';
+        }
+        out = put_int(out, player->score);
+        *out++ = ':';
+        out = put_list(out, player->discounts, TOKEN_MAX - 1);
+        *out++ = ':';
+        out = put_list(out, player->tokens, TOKEN_MAX);
+    }
+    return end_message(buffer, out);
+}
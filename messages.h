@@ -0,0 +1,28 @@
+#ifndef MESSAGES_H
+#define MESSAGES_H
+
+#include "shared.h"
+
+// Large enough for any message without a name in it.
+#define MESSAGE_BUFFER_SIZE 128
+// Large enough for a snapshot of a full board and MAX_PLAYERS players.
+#define SNAPSHOT_BUFFER_SIZE 4096
+
+/**
+ * Function prototypes. Each writes a newline terminated message in to the
+ * buffer, null terminates it and returns its length.
+ */
+int format_purchased(char *buffer, int playerId,
+        struct PurchaseMessage message);
+int format_took(char *buffer, int playerId, struct TakeMessage message);
+int format_wild(char *buffer, int playerId);
+int format_new_card(char *buffer, struct Card card);
+int format_disco(char *buffer, int playerId);
+int format_invalid(char *buffer, int playerId);
+int format_tokens(char *buffer, int tokens);
+int format_playinfo(char *buffer, int playerId, int playerCount);
+int format_rid(char *buffer, int size, char *gameName, int gameCounter,
+        int playerId);
+int format_snapshot(char *buffer, struct Game *game, int playerId);
+
+#endif
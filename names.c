@@ -0,0 +1,96 @@
+#include "shared.h"
+#include "names.h"
+
+/**
+ * Sets up an empty name index.
+ * @param index - The index to setup.
+ */
+void name_index_init(NameIndex *index) {
+    index->entryCount = 0;
+    index->capacity = NAME_INDEX_MIN_CAPACITY;
+    index->slots = calloc(index->capacity, sizeof(NameEntry *));
+}
+
+/**
+ * Frees a name index and all of its entries.
+ * @param index - The index to free.
+ */
+void name_index_free(NameIndex *index) {
+    for (int i = 0; i < index->capacity; i++) {
+        if (index->slots[i] != NULL) {
+            free(index->slots[i]->name);
+            free(index->slots[i]);
+        }
+    }
+    free(index->slots);
+}
+
+/**
+ * Finds the slot of a name, or the empty slot where it would go.
+ * @param index - The index to search.
+ * @param name - The name to find.
+ * @param hash - The hash of the name.
+ * @return the slot.
+ */
+static NameEntry **find_slot(NameIndex *index, char *name,
+        unsigned int hash) {
+    int mask = index->capacity - 1;
+    int i = hash & mask;
+    while (index->slots[i] != NULL && (index->slots[i]->hash != hash ||
+            strcmp(index->slots[i]->name, name) != 0)) {
+        i = (i + 1) & mask;
+    }
+    return &index->slots[i];
+}
+
+/**
+ * Doubles the capacity of a name index.
+ * @param index - The index to grow.
+ */
+static void grow_index(NameIndex *index) {
+    NameEntry **old = index->slots;
+    int oldCapacity = index->capacity;
+    index->capacity *= 2;
+    index->slots = calloc(index->capacity, sizeof(NameEntry *));
+    for (int i = 0; i < oldCapacity; i++) {
+        if (old[i] != NULL) {
+            *find_slot(index, old[i]->name, old[i]->hash) = old[i];
+        }
+    }
+    free(old);
+}
+
+/**
+ * Looks up a name.
+ * @param index - The index to search.
+ * @param name - The name to find.
+ * @return the entry of the name, NULL if it has never been added.
+ */
+NameEntry *name_index_find(NameIndex *index, char *name) {
+    return *find_slot(index, name, hash_name(name));
+}
+
+/**
+ * Looks up a name, adding an entry for it if it has never been seen.
+ * @param index - The index to add to.
+ * @param name - The name, which is copied.
+ * @return the entry of the name.
+ */
+NameEntry *name_index_add(NameIndex *index, char *name) {
+    if ((index->entryCount + 1) * 2 > index->capacity) {
+        grow_index(index);
+    }
+    unsigned int hash = hash_name(name);
+    NameEntry **slot = find_slot(index, name, hash);
+    if (*slot == NULL) {
+        NameEntry *entry = malloc(sizeof(NameEntry));
+        entry->name = malloc(sizeof(char) * (strlen(name) + 1));
+        strcpy(entry->name, name);
+        entry->hash = hash;
+        entry->gameCount = 0;
+        entry->lobby = NULL;
+        *slot = entry;
+        index->entryCount++;
+    }
+    return *slot;
+}
@@ -0,0 +1,36 @@
+#ifndef NAMES_H
+#define NAMES_H
+
+#define NAME_INDEX_MIN_CAPACITY 64
+
+/**
+ * Type defination for everything the server tracks about one game name.
+ * The lobby is the game with this name which is waiting for players, if
+ * there is one.
+ */
+typedef struct {
+    char *name;
+    unsigned int hash;
+    int gameCount;
+    void *lobby;
+} NameEntry;
+
+/**
+ * Type defination for an open addressing hash map of game names. Entries
+ * are allocated separately, so they keep their address as the map grows.
+ */
+typedef struct {
+    int entryCount;
+    int capacity;
+    NameEntry **slots;
+} NameIndex;
+
+/**
+ * Function prototypes.
+ */
+void name_index_init(NameIndex *index);
+void name_index_free(NameIndex *index);
+NameEntry *name_index_find(NameIndex *index, char *name);
+NameEntry *name_index_add(NameIndex *index, char *name);
+
+#endif
@@ -0,0 +1,165 @@
+#include <poll.h>
+#include "outbox.h"
+
+/**
+ * Writes every byte of a list of segments to a file descriptor, retrying
+ * after partial writes and waiting whenever a non-blocking descriptor is
+ * full. The segments are consumed as they are written. Waiting is bounded
+ * by WRITE_VECTOR_TIMEOUT in all, so a reader which stops reading cannot
+ * hold up the caller.
+ * @param fd - The file descriptor to write to.
+ * @param segments - The segments to write.
+ * @param count - The amount of segments.
+ * @return 0 on success, -1 if the descriptor could not be written to in
+ * time.
+ */
+int write_vector(int fd, struct iovec *segments, int count) {
+    uint64_t deadline = timer_now() + WRITE_VECTOR_TIMEOUT / TIMER_TICK_MS;
+    while (count > 0) {
+        ssize_t written = writev(fd, segments, count);
+        if (written == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            uint64_t now = timer_now();
+            if ((errno != EAGAIN && errno != EWOULDBLOCK) || now >= deadline) {
+                return -1;
+            }
+            struct pollfd writable = {fd, POLLOUT, 0};
+            if (poll(&writable, 1, (deadline - now) * TIMER_TICK_MS) == 0) {
+                return -1;
+            }
+            continue;
+        }
+        while (count > 0 && (size_t) written >= segments->iov_len) {
+            written -= segments->iov_len;
+            segments++;
+            count--;
+        }
+        if (count > 0) {
+            segments->iov_base = (char *) segments->iov_base + written;
+            segments->iov_len -= written;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Sets up an empty outbox.
+ * @param outbox - The outbox to setup.
+ * @param mailboxCount - The amount of players the outbox sends to.
+ * @param arena - The arena of the game, which holds the mailboxes until
+ * the game is over.
+ */
+void outbox_init(Outbox *outbox, int mailboxCount, Arena *arena) {
+    outbox->reactor = NULL;
+    outbox->overflowed = -1;
+    outbox->sharedLength = 0;
+    outbox->mailboxCount = mailboxCount;
+    outbox->mailboxes = arena_alloc(arena, sizeof(Mailbox) * mailboxCount);
+    for (int i = 0; i < mailboxCount; i++) {
+        outbox->mailboxes[i].connection = NULL;
+        outbox->mailboxes[i].count = 0;
+        outbox->mailboxes[i].ownLength = 0;
+    }
+}
+
+/**
+ * Sets the connection a mailbox is written to. Messages may be queued
+ * before then, but are only written once the mailbox has a connection.
+ * @param outbox - The outbox holding the mailbox.
+ * @param reactor - The reactor the connection is registered with.
+ * @param index - The index of the mailbox.
+ * @param connection - The connection of the player.
+ */
+void outbox_attach(Outbox *outbox, Reactor *reactor, int index,
+        Connection *connection) {
+    outbox->reactor = reactor;
+    outbox->mailboxes[index].connection = connection;
+}
+
+/**
+ * Adds bytes to the end of a mailbox, joining them on to the last segment
+ * when they directly follow it.
+ * @param mailbox - The mailbox to add to.
+ * @param bytes - The bytes, which must stay in place until flushed.
+ * @param length - The amount of bytes.
+ */
+static void append_segment(Mailbox *mailbox, char *bytes, int length) {
+    if (mailbox->count > 0) {
+        struct iovec *last = &mailbox->segments[mailbox->count - 1];
+        if ((char *) last->iov_base + last->iov_len == bytes) {
+            last->iov_len += length;
+            return;
+        }
+    }
+    mailbox->segments[mailbox->count].iov_base = bytes;
+    mailbox->segments[mailbox->count].iov_len = length;
+    mailbox->count++;
+}
+
+/**
+ * Queues a message for every player. The message is copied once no matter
+ * how many players there are.
+ * @param outbox - The outbox to queue in.
+ * @param message - The message to send.
+ * @param length - The length of the message.
+ */
+void outbox_broadcast(Outbox *outbox, char *message, int length) {
+    int full = outbox->sharedLength + length > OUTBOX_SHARED_SIZE;
+    for (int i = 0; !full && i < outbox->mailboxCount; i++) {
+        full = outbox->mailboxes[i].count == OUTBOX_SEGMENTS;
+    }
+    if (full) {
+        outbox_flush(outbox);
+    }
+    char *bytes = outbox->shared + outbox->sharedLength;
+    memcpy(bytes, message, length);
+    outbox->sharedLength += length;
+    for (int i = 0; i < outbox->mailboxCount; i++) {
+        append_segment(&outbox->mailboxes[i], bytes, length);
+    }
+}
+
+/**
+ * Queues a message for a single player.
+ * @param outbox - The outbox to queue in.
+ * @param index - The index of the player's mailbox.
+ * @param message - The message to send.
+ * @param length - The length of the message.
+ */
+void outbox_send(Outbox *outbox, int index, char *message, int length) {
+    Mailbox *mailbox = &outbox->mailboxes[index];
+    if (mailbox->ownLength + length > OUTBOX_PRIVATE_SIZE ||
+            mailbox->count == OUTBOX_SEGMENTS) {
+        outbox_flush(outbox);
+    }
+    char *bytes = mailbox->own + mailbox->ownLength;
+    memcpy(bytes, message, length);
+    mailbox->ownLength += length;
+    append_segment(mailbox, bytes, length);
+}
+
+/**
+ * Writes everything queued in an outbox, with one write per player which
+ * never blocks. A player who has been disconnected is skipped, as reading
+ * from them notices it.
+ * @param outbox - The outbox to flush.
+ * @return the index of the first player whose output has overflowed since
+ * the outbox was setup, -1 if no player has overflowed.
+ */
+int outbox_flush(Outbox *outbox) {
+    for (int i = 0; i < outbox->mailboxCount; i++) {
+        Mailbox *mailbox = &outbox->mailboxes[i];
+        if (mailbox->count > 0 && mailbox->connection != NULL &&
+                connection_write(outbox->reactor, mailbox->connection,
+                mailbox->segments, mailbox->count) == -1 &&
+                outbox->overflowed == -1) {
+            outbox->overflowed = i;
+        }
+        mailbox->count = 0;
+        mailbox->ownLength = 0;
+    }
+    outbox->sharedLength = 0;
+    return outbox->overflowed;
+}
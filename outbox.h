@@ -0,0 +1,59 @@
+#ifndef OUTBOX_H
+#define OUTBOX_H
+
+#include <sys/uio.h>
+#include "shared.h"
+#include "reactor.h"
+#include "arena.h"
+
+// Bytes of broadcasts held for one step of a game.
+#define OUTBOX_SHARED_SIZE 4096
+// Bytes of messages for a single player held for one step of a game, enough
+// for every message sent when a game starts or a snapshot of the game.
+#define OUTBOX_PRIVATE_SIZE 4096
+#define OUTBOX_SEGMENTS 16
+// Milliseconds write_vector waits for a full descriptor before giving up
+// on a reader which has stopped reading.
+#define WRITE_VECTOR_TIMEOUT 2000
+
+/**
+ * Type defination for the output of one player which is waiting to be
+ * written. Segments point either in to the shared broadcasts of the outbox
+ * or in to the player's own buffer, in the order they were sent.
+ */
+typedef struct {
+    Connection *connection;
+    int count;
+    struct iovec segments[OUTBOX_SEGMENTS];
+    int ownLength;
+    char own[OUTBOX_PRIVATE_SIZE];
+} Mailbox;
+
+/**
+ * Type defination for everything a game sends during one step, such as a
+ * move and the cards dealt after it. Broadcasts are copied in once and
+ * shared by every mailbox, then each player's output is written with a
+ * single write when the step is flushed. Players who fall too far behind
+ * are recorded as overflowed rather than holding up the game.
+ */
+typedef struct {
+    Reactor *reactor;
+    int overflowed;
+    int sharedLength;
+    char shared[OUTBOX_SHARED_SIZE];
+    int mailboxCount;
+    Mailbox *mailboxes;
+} Outbox;
+
+/**
+ * Function prototypes.
+ */
+int write_vector(int fd, struct iovec *segments, int count);
+void outbox_init(Outbox *outbox, int mailboxCount, Arena *arena);
+void outbox_attach(Outbox *outbox, Reactor *reactor, int index,
+        Connection *connection);
+void outbox_broadcast(Outbox *outbox, char *message, int length);
+void outbox_send(Outbox *outbox, int index, char *message, int length);
+int outbox_flush(Outbox *outbox);
+
+#endif
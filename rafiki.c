@@ -4,48 +4,65 @@
 // freeing memory when sigint or sigterm is caught
 Server *sigServer;
 
+/**
+ * Frees a game property along with every instance still stored in it.
+ * @param prop - The properties of the game.
+ */
+void free_game_prop(GameProp *prop) {
+    for (int j = 0; j < prop->instances.slotCount; j++) {
+        struct Game *instance = slab_get(&prop->instances, j,
+                slab_generation(&prop->instances, j));
+        if (instance != NULL) {
+            free_instance(instance);
+        }
+    }
+    slab_free(&prop->instances);
+    free(prop->shardSockets);
+    free(prop->latency);
+    free(prop->listeners);
+    free(prop->args);
+    free(prop->port);
+    free(prop->key);
+    free(prop);
+}
+
 /**
  * Frees memory allocated to the main server.
  * @param server - The server instance.
  */
 void free_server(Server *server) {
     for (int i = 0; i < server->portAmount; i++) {
-        GameProp prop = server->gameProps[i];
-        for (int j = 0; j < prop.instanceSize; j++) {
-            struct Game instance = prop.instances[j];
-            for (int k = 0; k < instance.playerCount; k++) {
-                struct GamePlayer player = instance.players[k];
-                fclose(player.toPlayer);
-                fclose(player.fromPlayer);
-                free(player.state.name);
-            }
-            free(instance.name);
-            if (instance.playerCount == prop.playerMax) {
-                free(instance.deck);
-            }
-            if (instance.playerCount > 0) {
-                free(instance.players);
-            }
-        }
-        free(prop.instances);
-        free(prop.instanceThreads);
-        free(prop.port);
-        free(prop.key);
-        free(prop.scoresTable.entries);
+        free_game_prop(server->gameProps[i]);
+    }
+    for (int i = 0; i < server->retiredAmount; i++) {
+        free_game_prop(server->retiredProps[i]);
     }
-    if (server->portAmount > 0) {
-        free(server->gameProps);
+    free(server->gameProps);
+    free(server->retiredProps);
+    free(server->key);
+    if (server->deck != NULL) {
+        shared_deck_release(server->deck);
     }
-    if (server->deckSize > 0) {
-        free(server->deck);
+    for (int i = 0; i < server->workerAmount; i++) {
+        if (server->workers[i].journal != NULL) {
+            journal_close(server->workers[i].journal);
+            free(server->workers[i].journal);
+        }
+    }
+    if (server->workerAmount > 0) {
+        free(server->workers);
     }
+    leaderboard_free(&server->leaderboard);
+    intern_table_free(&server->players);
+    name_index_free(&server->games);
+    session_table_free(&server->sessions);
 }
 
 /**
- * Exits the program with a error code.
+ * Prints the message for a error code.
  * @param int - Error code.
  */
-void exit_with_error(int error) {
+void report_error(int error) {
     switch(error) {
         case INVALID_ARG_NUM:
             fprintf(stderr, "Usage: rafiki keyfile deckfile statfile "\
@@ -70,6 +87,14 @@ void exit_with_error(int error) {
             fprintf(stderr, "System error\n");
             break;
     }
+}
+
+/**
+ * Exits the program with a error code.
+ * @param int - Error code.
+ */
+void exit_with_error(int error) {
+    report_error(error);
     exit(error);
 }
 
@@ -88,139 +113,25 @@ void check_args(int argc, char **argv) {
 }
 
 /**
- * Loads an deckfile to the server.
+ * Loads the deckfile the server starts with, exiting if it is invalid.
  * @param server - The server instance.
- * @param path - The path to the deckfile.
+ * @param path - The path of the deckfile.
  */
 void load_deckfile(Server *server, char *path) {
-    enum DeckStatus status;
-    status = parse_deck_file(&server->deckSize, &server->deck, path);
-    switch(status) {
-        case (VALID):
-            break;
-        case (DECK_ACCESS):
-            exit_with_error(INVALID_DECKFILE);
-        case (DECK_INVALID):
-            exit_with_error(INVALID_DECKFILE);
-    }
-}
-
-/**
- * Check and validates one line of the statfile
- * @param line - The string to check.
- * @returns 1 if the line is valid.
- */
-int check_stat_line(char *line) {
-    char *newLine = malloc(strlen(line) + 1);
-    strcpy(newLine, line);
-    newLine[strlen(line)] = '\0';
-    if (!match_seperators(newLine, 0, EXPECTED_STATFILE_SEP)) {
-        free(newLine);
-        return 0;
-    }
-    int isValid = 1;
-    char **commaSplit = split(newLine, ",");
-    for (int i = 0; i < EXPECTED_STATFILE_SEP + 1; i++) {
-        if (!is_string_digit(commaSplit[i]) ||
-                strcmp(commaSplit[i], "") == 0) {
-            isValid = 0;
-            break;
-        }
+    server->deck = read_deckfile(path);
+    if (server->deck == NULL) {
+        exit_with_error(INVALID_DECKFILE);
     }
-    free(commaSplit);
-    free(newLine);
-    return isValid;
 }
 
 /**
- * Generates one stat property from a statfile line.
- * @param line - The line to generate from.
- * @returns one entry to the statfile property.
- */
-Stat generate_stat(char *line) {
-    Stat stat;
-    char **contentSplit = split(line, ",");
-    stat.port = malloc(strlen(contentSplit[PORT]) + 1);
-    strcpy(stat.port, contentSplit[PORT]);
-    stat.port[strlen(contentSplit[PORT])] = '\0';
-    stat.tokens = atoi(contentSplit[START_TOKENS]);
-    stat.points = atoi(contentSplit[START_POINTS]);
-    stat.players = atoi(contentSplit[START_PLAYERS]);
-    free(contentSplit);
-    return stat;
-}
-
-/**
- * Gets the index of an non zero port.
- * @param prop - Statfile properties
- * @returns index of the port, -1 if the port is not in the property.
- */
-int index_of_non_zero_port(StatFileProp prop, char *port) {
-    int index = -1;
-    if (strcmp(port, "0") == 0) {
-        return -1;
-    }
-    for (int i = 0; i < prop.amount; i++) {
-        if (strcmp(prop.stats[i].port, port) == 0) {
-            index = i;
-            break;
-        }
-    }
-    return index;
-}
-
-/**
- * Loads a statfile.
+ * Loads the statfile the server starts with, exiting if it is invalid.
  * @param path - The path to the statfile.
  * @returns a statfile type loaded with values from the statfile.
  */
 StatFileProp load_statfile(char *path) {
     StatFileProp prop;
-    FILE *file = fopen(path, "r");
-    if (file == NULL || !file) {
-        exit_with_error(INVALID_STATFILE);
-    }
-    char *content = malloc(sizeof(char)), character;
-    int counter = 0, lines = 0, isValid = 1;
-    while((character = getc(file)) != EOF) {
-        content = realloc(content, sizeof(char) * (counter + 1));
-        content[counter++] = character;
-        if (character == '\n') {
-            lines++;
-        }
-    }
-    content = realloc(content, sizeof(char) * (counter + 1));
-    content[counter] = '\0';
-    if (lines == 0 && check_stat_line(content)) {
-        prop.stats = malloc(sizeof(Stat));
-        prop.stats[0] = generate_stat(content);
-        prop.amount = 1;
-    } else if (lines > 0) {
-        char **splitContent = split(content, "\n");
-        prop.stats = malloc(sizeof(Stat) * (lines + 1));
-        prop.amount = 0;
-        for (int i = 0; i < lines; i++) {
-            if (check_stat_line(splitContent[i])) {
-                Stat stat = generate_stat(splitContent[i]);
-                if (index_of_non_zero_port(prop, stat.port) != -1) {
-                    isValid = 0;
-                    break;
-                }
-                prop.stats[i] = stat;
-                prop.amount++;
-            } else {
-                isValid = 0;
-                break;
-            }
-        }
-        free(splitContent);
-    } else {
-        isValid = 0;
-    }
-    fclose(file);
-    free(content);
-    if (!isValid) {
-        free(prop.stats);
+    if (read_statfile(path, &prop) == -1) {
         exit_with_error(INVALID_STATFILE);
     }
     return prop;
@@ -230,8 +141,12 @@ StatFileProp load_statfile(char *path) {
  * Generates a socket from a provided port.
  * @param output - The output socket.
  * @param port - Port value to generate the socket from.
+ * @param shared - 1 if other sockets may listen on the same port, with the
+ * kernel spreading connections between them.
+ * @param backlog - How many connections the kernel may queue before they
+ * are accepted.
  */
-enum Error get_socket(int *output, char *port) {
+enum Error get_socket(int *output, char *port, int shared, int backlog) {
     struct addrinfo hints, *res, *res0;
     int sock;
     memset(&hints, 0, sizeof(hints));
@@ -250,14 +165,21 @@ enum Error get_socket(int *output, char *port) {
             sock = -1;
             continue;
         }
-        if (bind(sock, res->ai_addr, res->ai_addrlen) == -1) {
-            sock = -1;
+        int reuse = 1;
+        if (shared && setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, &reuse,
+                sizeof(int)) == -1) {
             close(sock);
+            sock = -1;
             continue;
         }
-        if (listen(sock, 5) == -1) {
+        if (bind(sock, res->ai_addr, res->ai_addrlen) == -1) {
+            close(sock);
             sock = -1;
+            continue;
+        }
+        if (listen(sock, backlog) == -1) {
             close(sock);
+            sock = -1;
             continue;
         }
         break;  /* okay we got one */
@@ -278,714 +200,2449 @@ enum Error get_socket(int *output, char *port) {
 
 
 /**
- * Adds one score entry type to the score table.
+ * Adds one score entry type to the server's leaderboard. Safe to call from
+ * any worker.
  * @param prop - The current game properties.
  * @param entry - The score entry to add.
  */
 void add_score_entry(GameProp *prop, ScoreEntry entry) {
-    int index = index_of_player_in_table(prop->scoresTable, entry.playerName);
-    ScoreTable *table = &prop->scoresTable;
-    if (index == -1) {
-        table->entries = realloc(table->entries, sizeof(ScoreEntry) *
-                (table->entryCount + 1));
-        table->entries[table->entryCount] = entry;
-        table->entryCount++;
-    } else {
-        table->entries[index].tokensTaken += entry.tokensTaken;
-        table->entries[index].pointsEarned += entry.pointsEarned;
-    }
+    leaderboard_add(prop->leaderboard, entry.player, entry.tokensTaken,
+            entry.pointsEarned);
 }
 
 /**
- * Update scores according to messages recieved from players.
+ * Records tokens or points a player earned with a move.
  * @param prop - The current game properties.
  * @param game - The current game instance.
- * @param type - The message type received from the player.
- * @param message - The message received from the player.
  * @param playerId - The ID of the player.
- * @return a error code depending on whether if the message is valid.
+ * @param tokensTaken - Tokens taken by the move.
+ * @param pointsEarned - Points earned by the move.
  */
-enum ErrorCode update_scores(GameProp *prop, struct Game *game,
-        enum MessageFromPlayer type, char *message, int playerId) {
+void update_scores(GameProp *prop, struct Game *game, int playerId,
+        int tokensTaken, int pointsEarned) {
     ScoreEntry entry;
-    entry.playerName = game->players[playerId].state.name;
-    entry.tokensTaken = 0;
-    entry.pointsEarned = 0;
-    enum ErrorCode err = 0;
-    if (type == PURCHASE) {
-        struct PurchaseMessage purchaseMessage;
-        err = parse_purchase_message(&purchaseMessage, message);
-        if (err) {
-            return err;
-        }
-        entry.pointsEarned = game->board[purchaseMessage.cardNumber].points;
-    } else if (type == TAKE) {
-        struct TakeMessage takeMessage;
-        err = parse_take_message(&takeMessage, message);
-        if (err) {
-            return err;
-        }
-        entry.tokensTaken = takeMessage.tokens[TOKEN_PURPLE] +
-                takeMessage.tokens[TOKEN_BROWN] +
-                takeMessage.tokens[TOKEN_YELLOW] +
-                takeMessage.tokens[TOKEN_RED];
-    } else if (type == WILD) {
-        entry.tokensTaken = 1;
-    } else {
-        return PROTOCOL_ERROR;
-    }
+    entry.player = interned_of(game->players[playerId].state.name);
+    entry.tokensTaken = tokensTaken;
+    entry.pointsEarned = pointsEarned;
     add_score_entry(prop, entry);
-    return err;
 }
 
-/* Process one player's turn, from sending the do what message to being ready
- * to send the do what message to the next player. Does not handle retries in
- * the case where the player sends an invalid message.
- * @param prop - The current game properties.
- * @param game - The current game instance.
+/**
+ * Plays a purchase message from a player.
+ * @param run - The game being played.
  * @param playerId - The ID of the player.
+ * @param line - The line the player sent.
  * @return a error code depending on whether if the message is valid.
  */
-enum ErrorCode do_what(GameProp *prop, struct Game *game, int playerId) {
-    enum ErrorCode err = 0;
-    FILE *toPlayer = game->players[playerId].toPlayer;
-    FILE *fromPlayer = game->players[playerId].fromPlayer;
-
-    fputs("dowhat\n", toPlayer);
-    fflush(toPlayer);
-
-    char *line;
-    int readBytes = read_line(fromPlayer, &line, 0);
-    if (readBytes <= 0) {
-        if (ferror(fromPlayer) && errno == EINTR) {
-            free(line);
-            return INTERRUPTED;
-        } else if (feof(fromPlayer)) {
-            free(line);
-            return PLAYER_CLOSED;
+enum ErrorCode play_purchase(GameRun *run, int playerId, char *line) {
+    struct Game *game = run->game;
+    struct PurchaseMessage message;
+    if (parse_purchase_message(&message, line) ||
+            message.cardNumber < 0 ||
+            message.cardNumber >= game->boardSize) {
+        return PROTOCOL_ERROR;
+    }
+    struct Player *player = &game->players[playerId].state;
+    struct Card card = game->board[message.cardNumber];
+    if (validate_costs(*player, card, message.costSpent)) {
+        return ILLEGAL_MOVE;
+    }
+    for (int i = 0; i < TOKEN_MAX; i++) {
+        player->tokens[i] -= message.costSpent[i];
+        if (i != TOKEN_WILD) {
+            game->tokenCount[i] += message.costSpent[i];
         }
     }
-    enum MessageFromPlayer type = classify_from_player(line);
-    if (update_scores(prop, game, type, line, playerId) != NOTHING_WRONG) {
-        free(line);
+    player->discounts[card.discount]++;
+    player->score += card.points;
+    // Close the gap, the board is refilled once the move is over.
+    memmove(&game->board[message.cardNumber],
+            &game->board[message.cardNumber + 1], sizeof(struct Card) *
+            (game->boardSize - message.cardNumber - 1));
+    game->boardSize--;
+    char buffer[MESSAGE_BUFFER_SIZE];
+    outbox_broadcast(&run->outbox, buffer,
+            format_purchased(buffer, playerId, message));
+    update_scores(run->prop, game, playerId, 0, card.points);
+    return NOTHING_WRONG;
+}
+
+/**
+ * Plays a take message from a player.
+ * @param run - The game being played.
+ * @param playerId - The ID of the player.
+ * @param line - The line the player sent.
+ * @return a error code depending on whether if the message is valid.
+ */
+enum ErrorCode play_take(GameRun *run, int playerId, char *line) {
+    struct Game *game = run->game;
+    struct TakeMessage message;
+    if (parse_take_message(&message, line)) {
         return PROTOCOL_ERROR;
     }
-    switch(type) {
+    if (process_take_tokens(game->tokenCount,
+            &game->players[playerId].state, message)) {
+        return ILLEGAL_MOVE;
+    }
+    char buffer[MESSAGE_BUFFER_SIZE];
+    outbox_broadcast(&run->outbox, buffer,
+            format_took(buffer, playerId, message));
+    update_scores(run->prop, game, playerId, message.tokens[TOKEN_PURPLE] +
+            message.tokens[TOKEN_BROWN] + message.tokens[TOKEN_YELLOW] +
+            message.tokens[TOKEN_RED], 0);
+    return NOTHING_WRONG;
+}
+
+/**
+ * Plays a wild message from a player.
+ * @param run - The game being played.
+ * @param playerId - The ID of the player.
+ */
+void play_wild(GameRun *run, int playerId) {
+    run->game->players[playerId].state.tokens[TOKEN_WILD]++;
+    char buffer[MESSAGE_BUFFER_SIZE];
+    outbox_broadcast(&run->outbox, buffer, format_wild(buffer, playerId));
+    update_scores(run->prop, run->game, playerId, 1, 0);
+}
+
+/* Process one player's move, from receiving their reply to the do what
+ * message to being ready to send the do what message to the next player.
+ * Does not handle retries in the case where the player sends an invalid
+ * message. Scores are only recorded for moves which are played.
+ * @param run - The game being played.
+ * @param playerId - The ID of the player.
+ * @param line - The line the player sent in reply.
+ * @return a error code depending on whether if the message is valid.
+ */
+enum ErrorCode do_what(GameRun *run, int playerId, char *line) {
+    switch(classify_from_player(line)) {
         case PURCHASE:
-            err = handle_purchase_message(playerId, game, line);
-            break;
+            return play_purchase(run, playerId, line);
         case TAKE:
-            err = handle_take_message(playerId, game, line);
-            break;
+            return play_take(run, playerId, line);
         case WILD:
-            handle_wild_message(playerId, game);
-            break;
+            play_wild(run, playerId);
+            return NOTHING_WRONG;
         default:
-            free(line);
             return PROTOCOL_ERROR;
     }
-    free(line);
-    return err;
 }
 
 /**
-* Send an message to all the players.
+ * Asks a player for their move.
+ * @param run - The game being played.
+ * @param playerId - The ID of the player.
+ */
+void send_do_what(GameRun *run, int playerId) {
+    outbox_send(&run->outbox, playerId, "dowhat\n", strlen("dowhat\n"));
+}
+
+/**
+ * Gets how long a player may take to reply before being dropped.
+ * @param prop - The game properties.
+ * @returns The timeout in milliseconds, 0 if players may take forever.
+ */
+int get_timeout_milliseconds(GameProp *prop) {
+    if (prop->timeout > INT_MAX / 1000) {
+        return INT_MAX;
+    }
+    return prop->timeout * 1000;
+}
+
+/**
+ * Writes everything a game has queued to its players. Players too far
+ * behind to keep up are dropped, ending the game as if they disconnected.
+ * @param reactor - The reactor of the worker playing the game.
+ * @param run - The game being played.
+ * @returns 1 if the game has ended.
+ */
+int flush_game(Reactor *reactor, GameRun *run) {
+    int slowPlayer = outbox_flush(&run->outbox);
+    if (slowPlayer != -1) {
+        end_game(reactor, run, DISCO, slowPlayer);
+        return 1;
+    }
+    return 0;
+}
+
+/**
+* Send an message to all the players straight away. Games being played
+* queue their messages in their outbox instead.
 * @param game - The game instance.
 * @param message - The message to send.
+* @param length - The length of the message.
 */
-void send_all(struct Game *game, char *message, ...) {
+void send_all(struct Game *game, char *message, int length) {
     for (int i = 0; i < game->playerCount; i++) {
-        va_list args;
-        va_start(args, message);
-        vfprintf(game->players[i].toPlayer, message, args);
-        fflush(game->players[i].toPlayer);
-        va_end(args);
+        struct iovec segment;
+        segment.iov_base = message;
+        segment.iov_len = length;
+        write_vector(game->players[i].fileDescriptor, &segment, 1);
     }
 }
 
 /**
- * A thread for handling one instance of a game.
- * @param arg - The GameInstanceArg type.
+ * Gets the ID of the player a connection belongs to.
+ * @param run - The game being played.
+ * @param connection - The connection of the player.
+ * @returns The ID of the player, -1 if the connection is not in the game.
  */
-void *game_instance_thread(void *arg) {
-    pthread_detach(pthread_self());
-    // Start playing game
-    GameProp *prop = (GameProp *) arg;
-    struct Game *game = &prop->instances[prop->currentGameIndex];
-    //printf("Game started!\n");
-    for (int i = 0; i < BOARD_SIZE; ++i) {
-        draw_card(game);
-    }
-    enum ErrorCode err = 0;
-    while(!is_game_over(game)) {
-        for (int i = 0; i < game->playerCount; i++) {
-            err = do_what(prop, game, i);
-            if (err == PROTOCOL_ERROR) {
-                err = do_what(prop, game, i);
-            }
-            if (err == PLAYER_CLOSED) {
-                char *message = print_disco_message(i);
-                send_all(game, message);
-                free(message);
-                return NULL;
-            }
-            if (err) {
-                char *message = print_invalid_message(i);
-                send_all(game, message);
-                free(message);
-                return NULL;
-            }
+int index_of_connection(GameRun *run, Connection *connection) {
+    for (int i = 0; i < run->game->playerCount; i++) {
+        if (run->connections[i] == connection) {
+            return i;
         }
     }
-    send_all(game, "eog\n");
-    return NULL;
+    return -1;
 }
 
 /**
- * Sets up the player file descriptors based on a socket.
- * @param player - The player which will be setup.
- * @param sock - The socket to setup from.
+ * Ends a game by sending a final message to all players, disconnecting
+ * them and returning the game's slot for reuse. Output still queued for a
+ * player is sent one last time without blocking, so the final message is
+ * only lost by a player whose socket is still full, or who fell so far
+ * behind they were already cut off. Scores are added as moves are made,
+ * so nothing else needs to be kept.
+ * @param reactor - The reactor of the worker playing the game.
+ * @param run - The game being played.
+ * @param type - END_OF_GAME, DISCO or INVALID.
+ * @param playerId - The player who disconnected or made an invalid move.
  */
-void setup_player_fd(struct GamePlayer *player, int sock) {
-    player->fileDescriptor = sock;
-    player->toPlayer = fdopen(sock, "w");
-    player->fromPlayer = fdopen(sock, "r");
+void end_game(Reactor *reactor, GameRun *run, enum MessageFromHub type,
+        int playerId) {
+    reactor_disarm(reactor, &run->turnTimer);
+    char buffer[MESSAGE_BUFFER_SIZE];
+    PlayCounters *plays = &run->prop->plays;
+    switch (type) {
+        case (DISCO):
+            outbox_broadcast(&run->outbox, buffer,
+                    format_disco(buffer, playerId));
+            __atomic_fetch_add(&plays->disconnects, 1, __ATOMIC_RELAXED);
+            break;
+        case (INVALID):
+            outbox_broadcast(&run->outbox, buffer,
+                    format_invalid(buffer, playerId));
+            __atomic_fetch_add(&plays->errors, 1, __ATOMIC_RELAXED);
+            break;
+        default:
+            outbox_broadcast(&run->outbox, "eog\n", strlen("eog\n"));
+    }
+    outbox_flush(&run->outbox);
+    journal_end(run);
+    remove_sessions(run);
+    for (int i = 0; i < run->game->playerCount; i++) {
+        reactor_disarm(reactor, &run->dropTimers[i]);
+        if (run->connections[i] != NULL) {
+            reactor_release(reactor, run->connections[i], 0);
+        }
+    }
+    shared_deck_release(run->deck);
+    __atomic_fetch_add(&plays->finished, 1, __ATOMIC_RELAXED);
+    // The run lives in the game's arena, so goes with the game.
+    reap_instance(run->prop, run->slot);
 }
 
 /**
- * Adds a player to a game instance.
- * @param player - The player to add.
- * @param sock - The game instance to add to.
+ * Ends a game when the current player has not replied in time.
+ * @param context - The reactor of the worker playing the game.
+ * @param timer - The turn timer of the game.
  */
-void add_player(struct Game *game, struct GamePlayer *player,
-        pthread_mutex_t *lock) {
-    //printf("ADDING PLAYER %s TO GAME %s\n", player->state.name, game->name);
-    int size = game->playerCount;
-    pthread_mutex_lock(lock);
-    game->players = realloc(game->players, sizeof(struct GamePlayer)
-            * (size + 1));
-    game->players[size] = *player;
-    game->playerCount++;
-    pthread_mutex_unlock(lock);
+void turn_expired(void *context, Timer *timer) {
+    GameRun *run = timer->data;
+    end_game((Reactor *) context, run, DISCO, run->currentPlayer);
 }
 
 /**
- * Sets up one instance of a game.
- * @param name - The name of the game.
- * @param token - The starting tokens in this game.
- * @param winScore - The required score to win.
+ * Ends a game when a player who dropped out has not reconnected in time.
+ * @param context - The reactor of the worker playing the game.
+ * @param timer - The drop timer of the player.
  */
-struct Game setup_instance(char *name, int token, int winScore) {
-    struct Game instance;
-    instance.players = malloc(0);
-    instance.playerCount = 0;
-    instance.name = malloc(sizeof(char) * strlen(name) + 1);
-    strcpy(instance.name, name);
-    free(name);
-    instance.name[strlen(instance.name)] = '\0';
-    instance.deckSize = 0;
-    instance.boardSize = 0;
-    instance.winScore = winScore;
-    for (int i = 0; i < TOKEN_MAX - 1; i++) {
-        instance.tokenCount[i] = token;
-    }
-    return instance;
+void drop_expired(void *context, Timer *timer) {
+    GameRun *run = timer->data;
+    end_game((Reactor *) context, run, DISCO, timer - run->dropTimers);
 }
 
 /**
- * Adds a game instance in to the game property it is derived from.
- * @param prop - The current game properties.
- * @param game - The current game instance.
- * @param lock - A mutex to prevent modifications to the game property.
+ * Drops a player whose connection has closed, keeping their place in the
+ * game until they reconnect or the reconnect window passes. Nothing is
+ * sent to them in the meantime, and the game waits if it is their turn.
+ * @param reactor - The reactor of the worker playing the game.
+ * @param run - The game being played.
+ * @param playerId - The player who dropped out.
  */
-void add_instance(GameProp *prop, struct Game game, pthread_mutex_t *lock) {
-    int size = prop->instanceSize;
-    pthread_mutex_lock(lock);
-    prop->instances = realloc(prop->instances, sizeof(struct Game) *
-            (size + 1));
-    prop->instances[size] = game;
-    prop->instanceSize++;
-    pthread_mutex_unlock(lock);
+void drop_player(Reactor *reactor, GameRun *run, int playerId) {
+    __atomic_fetch_add(&run->prop->plays.drops, 1, __ATOMIC_RELAXED);
+    reactor_release(reactor, run->connections[playerId], 1);
+    run->connections[playerId] = NULL;
+    run->game->players[playerId].fileDescriptor = -1;
+    outbox_attach(&run->outbox, reactor, playerId, NULL);
+    reactor_arm(reactor, &run->dropTimers[playerId],
+            run->prop->reconnectWindow * 1000);
 }
 
 /**
- * Retrieves the index of a instance.
- * @param prop - The current game properties.
- * @param name - The name of the instance.
- * @returns index of the instance, -1 if the instance is not in the property.
- */
-int index_of_instance(GameProp *prop, char *name) {
-    int index = -1;
-    for (int i = 0; i < prop->instanceSize; i++) {
-        if (strcmp(prop->instances[i].name, name) == 0) {
-            index = i;
-            break;
-        }
+ * Asks the current player for a move, and gives them until the timeout to
+ * reply. Their connection is read again if it was paused while they waited
+ * for their turn.
+ * @param reactor - The reactor of the worker playing the game.
+ * @param run - The game being played.
+ */
+void await_move(Reactor *reactor, GameRun *run) {
+    Connection *connection = run->connections[run->currentPlayer];
+    if (connection != NULL) {
+        connection_pause(reactor, connection, 0);
+    }
+    send_do_what(run, run->currentPlayer);
+    run->turnStart = latency_now();
+    int timeout = get_timeout_milliseconds(run->prop);
+    if (timeout > 0) {
+        reactor_arm(reactor, &run->turnTimer, timeout);
     }
-    return index;
 }
 
 /**
- * Sets up a single player.
- * @param player - The player to setup.
- * @param id - The id to give to this player.
- * @returns 1 if the player was successfully setup, 0 otherwise.
+ * Deals cards from the game's deck until the board is full or the deck
+ * runs out, telling every player about each card.
+ * @param run - The game being played.
  */
-int setup_player(struct GamePlayer *player, int id) {
-    struct Player state;
-    initialize_player(&state, id);
-    if (read_line(player->fromPlayer, &state.name, 0) <= 0) {
-        return 0;
+void refill_board(GameRun *run) {
+    struct Game *game = run->game;
+    while (game->boardSize < BOARD_SIZE &&
+            run->deckCursor < run->deck->size) {
+        struct Card card = run->deck->cards[run->deckCursor++];
+        game->board[game->boardSize++] = card;
+        char buffer[MESSAGE_BUFFER_SIZE];
+        outbox_broadcast(&run->outbox, buffer,
+                format_new_card(buffer, card));
     }
-    player->state = state;
-    return 1;
 }
 
 /**
- * Gets the total amount of games with a particular name active.
- * @param server - The server instance
- * @param name - The name of the game.
- * @returns The amount of games running with the provided name.
+ * Moves a game on to the next player's turn, ending it if the round is
+ * complete and the game is over.
+ * @param reactor - The reactor of the worker playing the game.
+ * @param run - The game being played.
+ * @returns 1 if the game has ended.
  */
-int get_game_amount(Server *server, char *name) {
-    int counter = 0;
-    for (int i = 0; i < server->portAmount; i++) {
-        GameProp prop = server->gameProps[i];
-        for (int j = 0; j < prop.instanceSize; j++) {
-            if (strcmp(prop.instances[j].name, name) == 0) {
-                counter++;
-            }
-        }
+int next_turn(Reactor *reactor, GameRun *run) {
+    run->attempts = 0;
+    run->currentPlayer++;
+    if (run->currentPlayer == run->game->playerCount) {
+        run->currentPlayer = 0;
     }
-    return counter;
+    if (run->currentPlayer == 0 && is_game_over(run->game)) {
+        end_game(reactor, run, END_OF_GAME, 0);
+        return 1;
+    }
+    await_move(reactor, run);
+    return 0;
 }
 
 /**
- * Compares the names of two players. Used for qsort.
- * @param a - The first player.
- * @param b - The second player.
+ * Plays as many turns of a game as the buffered input allows. A turn
+ * stays pending until the current player's reply arrives, so no thread is
+ * ever held waiting on a player. Everything sent along the way is written
+ * together once no more input is buffered.
+ * @param reactor - The reactor of the worker playing the game.
+ * @param run - The game being played.
  */
-int compare_name(const void *a, const void *b) {
-    struct GamePlayer *playerA = (struct GamePlayer *) a;
-    struct GamePlayer *playerB = (struct GamePlayer *) b;
-    char *nameA = playerA->state.name;
-    char *nameB = playerB->state.name;
-    return strcmp(nameA, nameB);
+void advance_game(Reactor *reactor, GameRun *run) {
+    while (1) {
+        int playerId = run->currentPlayer;
+        Connection *connection = run->connections[playerId];
+        char *line;
+        if (connection == NULL) {
+            // The player has dropped out, so wait for them to reconnect.
+            flush_game(reactor, run);
+            return;
+        }
+        if (connection_read_line(connection, &line) == -1) {
+            if (connection->closed) {
+                drop_player(reactor, run, playerId);
+                flush_game(reactor, run);
+            } else if (connection_is_full(connection)) {
+                end_game(reactor, run, INVALID, playerId);
+            } else {
+                flush_game(reactor, run);
+            }
+            return;
+        }
+        uint64_t received = latency_now();
+        histogram_record(&run->latency[TURN_LATENCY],
+                received - run->turnStart);
+        enum ErrorCode err = do_what(run, playerId, line);
+        histogram_record(&run->latency[MOVE_LATENCY],
+                latency_now() - received);
+        if (err == PROTOCOL_ERROR && run->attempts == 0) {
+            __atomic_fetch_add(&run->prop->plays.errors, 1,
+                    __ATOMIC_RELAXED);
+            run->attempts++;
+            await_move(reactor, run);
+            continue;
+        }
+        if (err) {
+            end_game(reactor, run, INVALID, playerId);
+            return;
+        }
+        journal_move(run, playerId, line);
+        __atomic_fetch_add(&run->prop->plays.moves, 1, __ATOMIC_RELAXED);
+        refill_board(run);
+        if (next_turn(reactor, run)) {
+            return;
+        }
+    }
 }
 
 /**
- * Assigns all players in a game an ID.
- * @param game - The current game instance.
+ * Handles input from a player in a game. Players who are waiting for their
+ * turn keep their input buffered until then, and stop being read once it
+ * fills, but are dropped from the game as soon as they disconnect.
+ * @param reactor - The reactor of the worker playing the game.
+ * @param connection - The connection of the player.
  */
-void assign_id(struct Game *game) {
-    qsort(game->players, game->playerCount, sizeof(struct GamePlayer),
-            compare_name);
-    for (int i = 0; i < game->playerCount; i++) {
-        game->players[i].state.playerId = i;
+void handle_game_input(Reactor *reactor, Connection *connection) {
+    GameRun *run = connection->data;
+    int playerId = index_of_connection(run, connection);
+    if (playerId == run->currentPlayer) {
+        advance_game(reactor, run);
+    } else if (connection->closed) {
+        drop_player(reactor, run, playerId);
+    } else if (!connection_has_room(connection)) {
+        connection_pause(reactor, connection, 1);
     }
 }
 
 /**
- * Sends initial messages to all players to setup their game states.
- * @param server - The server instance.
- * @param prop - The properties of the game.
- * @param game - The game instance.
+ * Sets up the turn timer and the drop timer of every player of a game.
+ * @param run - The game being played.
  */
-void send_game_initial_messages(Server *server, GameProp *prop,
-        struct Game game) {
-    int gameCounter = get_game_amount(server, game.name);
-    for (int i = 0; i < game.playerCount; i++) {
-        send_message(game.players[i].toPlayer, "rid%s,%i,%i\n", game.name,
-                gameCounter, game.players[i].state.playerId);
-        send_message(game.players[i].toPlayer, "playinfo%c/%i\n",
-                game.players[i].state.playerId + 'A', game.playerCount);
-        send_message(game.players[i].toPlayer, "tokens%i\n",
-                prop->startToken);
+void setup_game_timers(GameRun *run) {
+    timer_init(&run->turnTimer, turn_expired, run);
+    run->dropTimers = arena_alloc(run->arena,
+            sizeof(Timer) * run->game->playerCount);
+    for (int i = 0; i < run->game->playerCount; i++) {
+        timer_init(&run->dropTimers[i], drop_expired, run);
     }
 }
 
 /**
- * Sets up the scores table of a game property.
- * @param prop - The properties of the game.
- * @param instance - The game instance.
+ * Starts playing a game on a worker. Runs on the worker's thread.
+ * @param reactor - The reactor of the worker.
+ * @param arg - The GameRun type.
  */
-void setup_scores_table(GameProp *prop, struct Game *instance) {
-    for (int i = 0; i < instance->playerCount; i++) {
-        ScoreEntry entry;
-        entry.playerName = instance->players[i].state.name;
-        entry.tokensTaken = 0;
-        entry.pointsEarned = 0;
-        add_score_entry(prop, entry);
+void start_game(Reactor *reactor, void *arg) {
+    GameRun *run = (GameRun *) arg;
+    struct Game *game = run->game;
+    journal_game(run);
+    setup_game_timers(run);
+    run->connections = arena_alloc(run->arena,
+            sizeof(Connection *) * game->playerCount);
+    for (int i = 0; i < game->playerCount; i++) {
+        run->connections[i] = reactor_watch(reactor,
+                game->players[i].fileDescriptor, handle_game_input, run);
+        outbox_attach(&run->outbox, reactor, i, run->connections[i]);
+    }
+    for (int i = 0; i < game->playerCount; i++) {
+        if (run->connections[i] == NULL) {
+            end_game(reactor, run, DISCO, i);
+            return;
+        }
     }
+    // Players can only rejoin once the game has connections to swap.
+    add_sessions(run, reactor);
+    refill_board(run);
+    run->currentPlayer = 0;
+    run->attempts = 0;
+    if (is_game_over(game)) {
+        end_game(reactor, run, END_OF_GAME, 0);
+        return;
+    }
+    await_move(reactor, run);
+    histogram_record(&run->latency[START_LATENCY],
+            latency_now() - run->startTime);
+    flush_game(reactor, run);
 }
 
 /**
- * Begins to play a game by sending the required messages and creating a
- * thread for the game.
- * @param server - The server instance.
- * @param prop - The properties of the game.
- * @param index - The index of the current game.
- * @param lock - Mutex for preventing game properties from being modified.
+ * Queues a snapshot of a game for a player who has reconnected, which
+ * brings them up to date in one message however long the game has run.
+ * @param run - The game being played.
+ * @param playerId - The player who reconnected.
  */
-void play_game(Server *server, GameProp *prop, int index,
-        pthread_mutex_t *lock) {
-    struct Game *instance = &prop->instances[index];
-    int size = prop->instanceSize;
-    assign_id(instance);
-    setup_scores_table(prop, instance);
-    send_game_initial_messages(server, prop, *instance);
-    // Copy deck details in to game instance.
-    instance->deckSize = server->deckSize;
-    instance->deck = malloc(sizeof(struct Card) * server->deckSize);
-    memcpy(instance->deck, server->deck, sizeof(struct Card) *
-            server->deckSize);
-    pthread_mutex_lock(lock);
-    prop->instanceThreads = realloc(prop->instanceThreads, sizeof(pthread_t) *
-            (size));
-    prop->currentGameIndex = index;
-    pthread_create(&prop->instanceThreads[size - 1], NULL,
-            game_instance_thread, (void *) prop);
-    pthread_mutex_unlock(lock);
+void send_snapshot(GameRun *run, int playerId) {
+    char buffer[SNAPSHOT_BUFFER_SIZE];
+    outbox_send(&run->outbox, playerId, buffer,
+            format_snapshot(buffer, run->game, playerId));
 }
 
 /**
- * Creates a new game when a player attempts to join a game that does
- * not exist.
- * @param prop - The properties of the game.
- * @param index - The player that attempted to join this game.
- * @param name - The name of the game.
- * @param lock - Mutex for preventing game properties from being modified.
+ * Checks whether a player's seat is free to be taken back, which is only
+ * while they have dropped out and their reconnect window is open. Reconnect
+ * IDs can be worked out from the game's name, so a player who is still
+ * connected can never be pushed out of their seat.
+ * @param run - The game being played.
+ * @param playerId - The player reconnecting.
+ * @returns 1 if the player may rejoin.
  */
-void create_new_game(GameProp *prop, struct GamePlayer *player,
-        char *name, pthread_mutex_t *lock) {
-    //printf("SETTING UP NEW GAME\n");
-    struct Game instance = setup_instance(name, prop->startToken,
-            prop->winPoints);
-    if (!setup_player(player, instance.playerCount)) {
-        free(instance.players);
-        free(instance.name);
-        return;
-    }
-    add_player(&instance, player, lock);
-    add_instance(prop, instance, lock);
+int can_rejoin(GameRun *run, int playerId) {
+    return run->connections != NULL && run->connections[playerId] == NULL &&
+            timer_is_armed(&run->dropTimers[playerId]);
 }
 
 /**
- * Adds a player to a existing game with the same name.
- * @param prop - The properties of the game.
- * @param index - The player that attempted to join this game.
- * @param index - The index of the game.
- * @param lock - Mutex for preventing game properties from being modified.
+ * Swaps a reconnecting player's socket in to their game and brings them up
+ * to date. Runs on the worker playing the game, so the game cannot end
+ * while the socket is swapped in. The player is turned away unless their
+ * seat is free to be taken back.
+ * @param reactor - The reactor of the worker.
+ * @param arg - The Rejoin type, which is freed.
  */
-void add_to_existing_game(GameProp *prop, struct GamePlayer *player,
-        int index, pthread_mutex_t *lock) {
-    setup_player(player, prop->instances[index].playerCount);
-    add_player(&prop->instances[index], player, lock);
+void rejoin_game(Reactor *reactor, void *arg) {
+    Rejoin *rejoin = (Rejoin *) arg;
+    Session session;
+    int found = session_table_find(rejoin->sessions, rejoin->rid, &session);
+    int sock = rejoin->sock;
+    free(rejoin->rid);
+    free(rejoin);
+    Connection *connection = NULL;
+    if (found && can_rejoin(session.game, session.playerId)) {
+        connection = reactor_watch(reactor, sock, handle_game_input,
+                session.game);
+    }
+    if (connection == NULL) {
+        send_reply(sock, "no\n");
+        close(sock);
+        return;
+    }
+    GameRun *run = session.game;
+    int playerId = session.playerId;
+    reactor_disarm(reactor, &run->dropTimers[playerId]);
+    run->connections[playerId] = connection;
+    run->game->players[playerId].fileDescriptor = sock;
+    outbox_attach(&run->outbox, reactor, playerId, connection);
+    send_snapshot(run, playerId);
+    if (run->currentPlayer == playerId) {
+        send_do_what(run, playerId);
+    }
+    flush_game(reactor, run);
 }
 
 /**
- * Gets the index of a non full game with a particulat name on
- * a given game property.
+ * Journals the start of a game along with who is playing it, if the game is
+ * being journaled. The game's properties are journaled by the port from the
+ * statfile, which still names them after a reload or a restart.
+ * @param run - The game being played.
+ */
+void journal_game(GameRun *run) {
+    if (run->journal == NULL) {
+        return;
+    }
+    struct Game *game = run->game;
+    journal_record(run->journal, "S %ld %s %d %d %s", run->serial,
+            run->prop->anyPort ? "0" : run->prop->port, run->gameCounter,
+            game->playerCount, game->name);
+    for (int i = 0; i < game->playerCount; i++) {
+        journal_record(run->journal, "P %ld %d %s", run->serial, i,
+                game->players[i].state.name);
+    }
+}
+
+/**
+ * Journals a move which has been played, if the game is being journaled.
+ * @param run - The game being played.
+ * @param playerId - The ID of the player.
+ * @param line - The line the player sent.
+ */
+void journal_move(GameRun *run, int playerId, char *line) {
+    if (run->journal != NULL) {
+        journal_record(run->journal, "M %ld %d %s", run->serial, playerId,
+                line);
+    }
+}
+
+/**
+ * Journals the end of a game, if the game is being journaled.
+ * @param run - The game being played.
+ */
+void journal_end(GameRun *run) {
+    if (run->journal != NULL) {
+        journal_record(run->journal, "E %ld", run->serial);
+    }
+}
+
+/**
+ * Commits everything a worker journaled while handling the events it was
+ * woken for. Runs once per loop, so records from every game on the worker
+ * share a single write.
+ * @param reactor - The reactor of the worker.
+ * @param arg - The Journal type of the worker.
+ */
+void commit_journal(Reactor *reactor, void *arg) {
+    journal_commit((Journal *) arg);
+}
+
+/**
+ * Stops a worker once the server is shutting down, committing and closing
+ * its journal first. Runs on the worker's thread, so nothing else can be
+ * writing to the journal.
+ * @param reactor - The reactor of the worker.
+ * @param arg - The Worker type.
+ */
+void stop_worker(Reactor *reactor, void *arg) {
+    Worker *worker = (Worker *) arg;
+    if (worker->journal != NULL) {
+        journal_close(worker->journal);
+        free(worker->journal);
+        worker->journal = NULL;
+    }
+    reactor->idle = NULL;
+    reactor->running = 0;
+}
+
+/**
+ * A thread which plays every game assigned to a worker.
+ * @param arg - The Worker type.
+ */
+void *worker_thread(void *arg) {
+    Worker *worker = (Worker *) arg;
+    reactor_run(&worker->reactor);
+    return NULL;
+}
+
+/**
+ * Sets up one worker per available core, or one per accepting socket of a
+ * port if there are more of those.
+ * @param server - The server instance.
+ */
+void setup_workers(Server *server) {
+    server->workerAmount = max(server->acceptorAmount,
+            (int) sysconf(_SC_NPROCESSORS_ONLN));
+    server->nextWorker = 0;
+    server->workers = malloc(sizeof(Worker) * server->workerAmount);
+    for (int i = 0; i < server->workerAmount; i++) {
+        if (reactor_init(&server->workers[i].reactor,
+                server->backend) == -1) {
+            exit_with_error(SYSTEM_ERR);
+        }
+        server->workers[i].reactor.highWater = server->highWater;
+        server->workers[i].journal = NULL;
+    }
+}
+
+/**
+ * Starts the thread of every worker.
+ * @param server - The server instance.
+ */
+void start_workers(Server *server) {
+    for (int i = 0; i < server->workerAmount; i++) {
+        pthread_create(&server->workers[i].thread, NULL, worker_thread,
+                (void *) &server->workers[i]);
+    }
+}
+
+/**
+ * Sets up the player file descriptors based on a socket.
+ * @param player - The player which will be setup.
+ * @param sock - The socket to setup from.
+ */
+void setup_player_fd(struct GamePlayer *player, int sock) {
+    player->fileDescriptor = sock;
+    // Input is read by the reactor and output is written by the game's
+    // outbox, so the socket is never wrapped in a stream.
+    player->toPlayer = NULL;
+    player->fromPlayer = NULL;
+}
+
+/**
+ * Adds a player to a game instance. The players are kept in the game's
+ * arena, and are moved to twice the room whenever the room runs out.
+ * @param game - The game instance to add to.
+ * @param player - The player to add.
+ * @param arena - The arena of the game.
+ * @param lock - Mutex for preventing game properties from being modified.
+ */
+void add_player(struct Game *game, struct GamePlayer *player,
+        Arena *arena, pthread_mutex_t *lock) {
+    //printf("ADDING PLAYER %s TO GAME %s\n", player->state.name, game->name);
+    int size = game->playerCount;
+    pthread_mutex_lock(lock);
+    if ((size & (size - 1)) == 0) {
+        struct GamePlayer *players = arena_alloc(arena,
+                sizeof(struct GamePlayer) * (size == 0 ? 1 : size * 2));
+        memcpy(players, game->players, sizeof(struct GamePlayer) * size);
+        game->players = players;
+    }
+    game->players[size] = *player;
+    game->playerCount++;
+    pthread_mutex_unlock(lock);
+}
+
+/**
+ * Sets up one instance of a game.
+ * @param arena - The arena of the game, which the name is copied in to.
+ * @param name - The name of the game.
+ * @param token - The starting tokens in this game.
+ * @param winScore - The required score to win.
+ */
+struct Game setup_instance(Arena *arena, char *name, int token,
+        int winScore) {
+    struct Game instance;
+    instance.players = NULL;
+    instance.playerCount = 0;
+    instance.name = arena_copy_string(arena, name);
+    instance.deckSize = 0;
+    instance.deck = NULL;
+    instance.boardSize = 0;
+    instance.data = NULL;
+    instance.winScore = winScore;
+    for (int i = 0; i < TOKEN_MAX - 1; i++) {
+        instance.tokenCount[i] = token;
+    }
+    return instance;
+}
+
+/**
+ * Gets the amount of memory a game is expected to allocate from its arena,
+ * so that a game which fills up only needs one block.
+ * @param playerMax - The amount of players in the game.
+ * @returns The amount of bytes.
+ */
+size_t get_arena_size(int playerMax) {
+    size_t perPlayer = 2 * sizeof(struct GamePlayer) + sizeof(Mailbox) +
+            sizeof(Connection *) + sizeof(Timer) + 2 * ARENA_ALIGN;
+    return sizeof(GameRun) + sizeof(Lobby) + ARENA_NAME_SIZE +
+            8 * ARENA_ALIGN + perPlayer * playerMax;
+}
+
+/**
+ * Takes a slot for a new game instance in the game property it is derived
+ * from. The instance is then setup in place using the slot's arena.
+ * @param prop - The current game properties.
+ * @returns The index of the instance, which keeps its address until the
+ * instance is reaped.
+ */
+int add_instance(GameProp *prop) {
+    return slab_alloc(&prop->instances);
+}
+
+/**
+ * Disconnects the players of a game instance and frees anything it holds
+ * outside of its arena.
+ * @param instance - The game instance.
+ */
+void free_instance(struct Game *instance) {
+    for (int i = 0; i < instance->playerCount; i++) {
+        close(instance->players[i].fileDescriptor);
+    }
+    free(instance->deck);
+}
+
+/**
+ * Frees a game instance which is over and returns its slot to the game
+ * property for reuse, which frees its arena in one go.
+ * @param prop - The properties of the game.
+ * @param index - The index of the instance.
+ */
+void reap_instance(GameProp *prop, int index) {
+    free_instance(slab_at(&prop->instances, index));
+    slab_release(&prop->instances, index);
+}
+
+/**
+ * Sets up a single player. The player's name is the canonical string of
+ * their interned name, which every game they play shares.
+ * @param player - The player to setup.
+ * @param id - The id to give to this player.
+ * @param name - The name the player sent during its handshake.
+ */
+void setup_player(struct GamePlayer *player, int id, InternedName *name) {
+    struct Player state;
+    initialize_player(&state, id);
+    state.name = name->name;
+    player->state = state;
+}
+
+/**
+ * Gets the total amount of games with a particular name created since the
+ * server started.
+ * @param server - The server instance
+ * @param name - The name of the game.
+ * @returns The amount of games created with the provided name.
+ */
+int get_game_amount(Server *server, char *name) {
+    NameEntry *entry = name_index_find(&server->games, name);
+    return entry == NULL ? 0 : entry->gameCount;
+}
+
+/**
+ * Compares the names of two players. Used for qsort.
+ * @param a - The first player.
+ * @param b - The second player.
+ */
+int compare_name(const void *a, const void *b) {
+    struct GamePlayer *playerA = (struct GamePlayer *) a;
+    struct GamePlayer *playerB = (struct GamePlayer *) b;
+    char *nameA = playerA->state.name;
+    char *nameB = playerB->state.name;
+    return strcmp(nameA, nameB);
+}
+
+/**
+ * Assigns all players in a game an ID.
+ * @param game - The current game instance.
+ */
+void assign_id(struct Game *game) {
+    qsort(game->players, game->playerCount, sizeof(struct GamePlayer),
+            compare_name);
+    for (int i = 0; i < game->playerCount; i++) {
+        game->players[i].state.playerId = i;
+    }
+}
+
+/**
+ * Queues initial messages to all players to setup their game states. They
+ * are written along with the first cards and move of the game.
+ * @param server - The server instance.
+ * @param run - The game about to be played.
+ */
+void send_game_initial_messages(Server *server, GameRun *run) {
+    struct Game *game = run->game;
+    int gameCounter = get_game_amount(server, game->name);
+    run->gameCounter = gameCounter;
+    // Names are at most a line long, the rest of the messages fit easily.
+    char buffer[LINE_READER_SIZE + 3 * MESSAGE_BUFFER_SIZE];
+    char tokens[MESSAGE_BUFFER_SIZE];
+    int tokensLength = format_tokens(tokens, run->prop->startToken);
+    for (int i = 0; i < game->playerCount; i++) {
+        int id = game->players[i].state.playerId;
+        int length = format_rid(buffer, LINE_READER_SIZE +
+                MESSAGE_BUFFER_SIZE, game->name, gameCounter, id);
+        length += format_playinfo(buffer + length, id, game->playerCount);
+        memcpy(buffer + length, tokens, tokensLength + 1);
+        length += tokensLength;
+        outbox_send(&run->outbox, i, buffer, length);
+    }
+}
+
+/**
+ * Gets the key a player's session is stored under, their reconnect id.
+ * @param buffer - Where to write, RID_BUFFER_SIZE long.
+ * @param run - The game being played.
+ * @param playerId - The ID of the player.
+ * @returns The key, which is inside the buffer.
+ */
+char *get_session_key(char *buffer, GameRun *run, int playerId) {
+    int length = format_rid(buffer, RID_BUFFER_SIZE, run->game->name,
+            run->gameCounter, playerId);
+    buffer[length - 1] = '\0';
+    return buffer + strlen("rid");
+}
+
+/**
+ * Adds a session for every player of a game, so they can reconnect.
+ * @param run - The game being played.
+ * @param reactor - The reactor of the worker playing the game.
+ */
+void add_sessions(GameRun *run, Reactor *reactor) {
+    char buffer[RID_BUFFER_SIZE];
+    for (int i = 0; i < run->game->playerCount; i++) {
+        session_table_add(run->sessions, get_session_key(buffer, run, i),
+                run, reactor, i);
+    }
+}
+
+/**
+ * Removes the session of every player of a game which is ending.
+ * @param run - The game being played.
+ */
+void remove_sessions(GameRun *run) {
+    char buffer[RID_BUFFER_SIZE];
+    for (int i = 0; i < run->game->playerCount; i++) {
+        session_table_remove(run->sessions, get_session_key(buffer, run, i));
+    }
+}
+
+/**
+ * Sets up the scores table of a game property.
+ * @param prop - The properties of the game.
+ * @param instance - The game instance.
+ */
+void setup_scores_table(GameProp *prop, struct Game *instance) {
+    for (int i = 0; i < instance->playerCount; i++) {
+        ScoreEntry entry;
+        entry.player = interned_of(instance->players[i].state.name);
+        entry.tokensTaken = 0;
+        entry.pointsEarned = 0;
+        add_score_entry(prop, entry);
+    }
+}
+
+/**
+ * Drops every player waiting in a lobby which did not fill up in time. The
+ * players are told the first empty seat disconnected, and the lobby is no
+ * longer offered to new players.
+ * @param context - The acceptor reactor.
+ * @param timer - The timer of the lobby.
+ */
+void lobby_expired(void *context, Timer *timer) {
+    Lobby *lobby = timer->data;
+    struct Game *instance = slab_at(&lobby->prop->instances, lobby->index);
+    char buffer[MESSAGE_BUFFER_SIZE];
+    send_all(instance, buffer, format_disco(buffer, instance->playerCount));
+    lobby->entry->lobby = NULL;
+    lobby->prop->lobbies--;
+    lobby->prop->waiting -= instance->playerCount;
+    // The lobby lives in the game's arena, so goes with the game.
+    reap_instance(lobby->prop, lobby->index);
+}
+
+/**
+ * Keeps a game which is not yet full open for players, restarting its
+ * deadline. Runs on the acceptor's thread.
+ * @param server - The server instance.
+ * @param prop - The properties of the game.
+ * @param index - The index of the game.
+ */
+void wait_for_players(Server *server, GameProp *prop, int index) {
+    struct Game *instance = slab_at(&prop->instances, index);
+    Lobby *lobby = instance->data;
+    if (lobby == NULL) {
+        lobby = arena_alloc(slab_arena(&prop->instances, index),
+                sizeof(Lobby));
+        lobby->prop = prop;
+        lobby->index = index;
+        lobby->generation = slab_generation(&prop->instances, index);
+        lobby->entry = name_index_find(&server->games, instance->name);
+        lobby->entry->lobby = lobby;
+        timer_init(&lobby->timer, lobby_expired, lobby);
+        instance->data = lobby;
+        prop->lobbies++;
+    }
+    int timeout = get_timeout_milliseconds(prop);
+    if (timeout > 0) {
+        reactor_arm(&server->acceptor, &lobby->timer, timeout);
+    }
+}
+
+/**
+ * Stops a game from waiting for players.
+ * @param server - The server instance.
+ * @param instance - The game instance.
+ */
+void close_lobby(Server *server, struct Game *instance) {
+    Lobby *lobby = instance->data;
+    if (lobby == NULL) {
+        return;
+    }
+    reactor_disarm(&server->acceptor, &lobby->timer);
+    lobby->entry->lobby = NULL;
+    lobby->prop->lobbies--;
+    instance->data = NULL;
+}
+
+/**
+ * Picks the worker to hand the next game to, taking turns between them.
+ * @param server - The server instance.
+ * @param lock - Mutex for preventing game properties from being modified.
+ * @returns The worker.
+ */
+Worker *next_worker(Server *server, pthread_mutex_t *lock) {
+    pthread_mutex_lock(lock);
+    Worker *worker = &server->workers[server->nextWorker];
+    server->nextWorker = (server->nextWorker + 1) % server->workerAmount;
+    pthread_mutex_unlock(lock);
+    return worker;
+}
+
+/**
+ * Begins to play a game by sending the required messages and handing the
+ * game to the next worker.
+ * @param server - The server instance.
+ * @param prop - The properties of the game.
+ * @param index - The index of the current game.
+ * @param lock - Mutex for preventing game properties from being modified.
+ */
+void play_game(Server *server, GameProp *prop, int index,
+        pthread_mutex_t *lock) {
+    uint64_t startTime = latency_now();
+    struct Game *instance = slab_at(&prop->instances, index);
+    close_lobby(server, instance);
+    assign_id(instance);
+    setup_scores_table(prop, instance);
+    // Games draw from the shared deck through their own cursor, so the
+    // instance is given no deck for the library to draw from.
+    Arena *arena = slab_arena(&prop->instances, index);
+    GameRun *run = arena_alloc(arena, sizeof(GameRun));
+    run->prop = prop;
+    run->deck = shared_deck_acquire(server->deck);
+    run->deckCursor = 0;
+    run->slot = index;
+    run->game = instance;
+    run->arena = arena;
+    run->connections = NULL;
+    run->dropTimers = NULL;
+    run->sessions = &server->sessions;
+    run->serial = server->journalSerial++;
+    run->startTime = startTime;
+    outbox_init(&run->outbox, instance->playerCount, arena);
+    send_game_initial_messages(server, run);
+    Worker *worker = next_worker(server, lock);
+    run->journal = worker->journal;
+    run->latency = get_latency(server, prop, &worker->reactor);
+    reactor_post(&worker->reactor, start_game, run);
+}
+
+/**
+ * Creates a new game when a player attempts to join a game that does
+ * not exist.
+ * @param prop - The properties of the game.
+ * @param index - The player that attempted to join this game.
+ * @param name - The name of the game, which is copied.
+ * @param playerName - The name of the player, which is copied.
+ * @param lock - Mutex for preventing game properties from being modified.
+ * @returns The index of the new game.
+ */
+int create_new_game(GameProp *prop, struct GamePlayer *player,
+        char *name, InternedName *playerName, pthread_mutex_t *lock) {
+    //printf("SETTING UP NEW GAME\n");
+    int index = add_instance(prop);
+    struct Game *instance = slab_at(&prop->instances, index);
+    Arena *arena = slab_arena(&prop->instances, index);
+    *instance = setup_instance(arena, name, prop->startToken,
+            prop->winPoints);
+    setup_player(player, instance->playerCount, playerName);
+    add_player(instance, player, arena, lock);
+    return index;
+}
+
+/**
+ * Adds a player to a existing game with the same name.
+ * @param prop - The properties of the game.
  * @param index - The player that attempted to join this game.
+ * @param playerName - The name of the player, which is copied.
+ * @param index - The index of the game.
+ * @param lock - Mutex for preventing game properties from being modified.
+ */
+void add_to_existing_game(GameProp *prop, struct GamePlayer *player,
+        InternedName *playerName, int index, pthread_mutex_t *lock) {
+    struct Game *instance = slab_at(&prop->instances, index);
+    Arena *arena = slab_arena(&prop->instances, index);
+    setup_player(player, instance->playerCount, playerName);
+    add_player(instance, player, arena, lock);
+}
+
+/**
+ * Gets the index of a non full game with a particulat name on
+ * all game properties (i.e all ports). There is never more than one such
+ * game, as players only create a game when none is waiting.
+ * @param server - The server instance.
  * @param name - The name of the game.
+ * @param propOut - The properties of the game, which may no longer be
+ * accepting players on their own port.
  * @returns The index of the game, -1 if the game does not exist.
  */
-int get_avaliable_game(GameProp *prop, char *name) {
-    int index = -1;
-    for (int i = 0; i < prop->instanceSize; i++) {
-        if (strcmp(prop->instances[i].name, name) == 0 &&
-                !(prop->instances[i].playerCount >= prop->playerMax)) {
-            index = i;
-            break;
+int get_avaliable_game_all(Server *server, char *name, GameProp **propOut) {
+    NameEntry *entry = name_index_find(&server->games, name);
+    if (entry == NULL || entry->lobby == NULL) {
+        return -1;
+    }
+    Lobby *lobby = entry->lobby;
+    if (slab_get(&lobby->prop->instances, lobby->index,
+            lobby->generation) == NULL) {
+        return -1;
+    }
+    *propOut = lobby->prop;
+    return lobby->index;
+}
+
+/**
+ * Gets the properties of a game based on the port.
+ * all game properties (i.e all ports).
+ * @param server - The server instance.
+ * @param port - The port to retrieve game properties from.
+ * @returns The game properties associated with the port, NULL if none found.
+ */
+GameProp *get_prop_by_port(Server *server, char *port) {
+    for (int i = 0; i < server->portAmount; i++) {
+        if (strcmp(server->gameProps[i]->port, port) == 0) {
+            return server->gameProps[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Sends the scores of every player on the server to a connection. The
+ * listing is a snapshot, so games keep scoring while it is sent.
+ * @param server - The server instance.
+ * @param sock - The connection to send to.
+ */
+void send_scores(Server *server, int sock) {
+    ScoreSnapshot *snapshot = leaderboard_acquire(&server->leaderboard);
+    struct iovec segment = {snapshot->text, snapshot->length};
+    write_vector(sock, &segment, 1);
+    snapshot_release(snapshot);
+}
+
+/**
+ * A thread for sending the combined scores to a connection, so that a slow
+ * reader does not hold up the acceptor.
+ * @param arg - The ScoresArgs type.
+ */
+void *scores_thread(void *arg) {
+    pthread_detach(pthread_self());
+    ScoresArgs *args = (ScoresArgs *) arg;
+    send_scores(args->server, args->sock);
+    close(args->sock);
+    free(args);
+    return NULL;
+}
+
+/**
+ * Gets the time from a monotonic clock.
+ * @returns The amount of milliseconds since an arbitrary point.
+ */
+long get_milliseconds(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+/**
+ * Writes the row of stats for one game property.
+ * @param output - The stream to write to.
+ * @param prop - The properties of the game.
+ * @param listening - 1 if the port is accepting players, 0 if a reload has
+ * removed it and it only has games left to finish.
+ */
+void write_prop_stats(FILE *output, GameProp *prop, int listening) {
+    // Lobbies are stored with the games, but are not being played yet.
+    int active = slab_in_use(&prop->instances) - prop->lobbies;
+    fprintf(output, "%s,%d,%d,%lu,%d,%d,%lu,%lu,%lu,%lu,%lu,%lu\n",
+            prop->port, listening, active,
+            __atomic_load_n(&prop->plays.finished, __ATOMIC_RELAXED),
+            prop->lobbies, prop->waiting,
+            __atomic_load_n(&prop->plays.moves, __ATOMIC_RELAXED),
+            __atomic_load_n(&prop->plays.errors, __ATOMIC_RELAXED),
+            __atomic_load_n(&prop->plays.disconnects, __ATOMIC_RELAXED),
+            __atomic_load_n(&prop->plays.drops, __ATOMIC_RELAXED),
+            __atomic_load_n(&prop->accepts.accepted, __ATOMIC_RELAXED),
+            __atomic_load_n(&prop->accepts.fullDrains, __ATOMIC_RELAXED));
+}
+
+/**
+ * Formats a report of the live counters of the server. Moves per second
+ * are measured since the last report. Runs on the acceptor's thread, which
+ * owns the game properties.
+ * @param server - The server instance.
+ * @param length - Set to the length of the report.
+ * @returns The report, which the caller must free.
+ */
+char *format_stats(Server *server, int *length) {
+    long now = get_milliseconds();
+    // Players waiting in lobbies are connected, but no reactor watches them.
+    int connections = reactor_connection_count(&server->acceptor);
+    for (int i = 0; i < server->workerAmount; i++) {
+        connections += reactor_connection_count(&server->workers[i].reactor);
+    }
+    unsigned long moves = 0;
+    size_t slabBytes = 0;
+    for (int i = 0; i < server->portAmount + server->retiredAmount; i++) {
+        GameProp *prop = i < server->portAmount ? server->gameProps[i] :
+                server->retiredProps[i - server->portAmount];
+        connections += prop->waiting;
+        moves += __atomic_load_n(&prop->plays.moves, __ATOMIC_RELAXED);
+        slabBytes += slab_bytes(&prop->instances);
+    }
+    long elapsed = now - server->statsTime;
+    double rate = elapsed <= 0 ? 0 :
+            (moves - server->statsMoves) * 1000.0 / elapsed;
+    server->statsTime = now;
+    server->statsMoves = moves;
+    char *text;
+    size_t size;
+    FILE *output = open_memstream(&text, &size);
+    fprintf(output, "Uptime Seconds,%.3f\n",
+            (now - server->startTime) / 1000.0);
+    fprintf(output, "Connections,%d\n", connections);
+    fprintf(output, "Moves Per Second,%.1f\n", rate);
+    fprintf(output, "Arena Bytes,%zu\n", arena_held_bytes());
+    fprintf(output, "Slab Bytes,%zu\n", slabBytes);
+    fprintf(output, "Players,%d\n",
+            __atomic_load_n(&server->players.nextId, __ATOMIC_RELAXED));
+    fprintf(output, "Port,Listening,Active Games,Finished Games,"
+            "Open Lobbies,Waiting Players,Moves,Protocol Errors,Disconnects,"
+            "Drops,Accepted,Full Drains\n");
+    for (int i = 0; i < server->portAmount; i++) {
+        write_prop_stats(output, server->gameProps[i], 1);
+    }
+    for (int i = 0; i < server->retiredAmount; i++) {
+        write_prop_stats(output, server->retiredProps[i], 0);
+    }
+    fprintf(output, "Worker,Queue Depth,Connections\n");
+    for (int i = 0; i < server->workerAmount; i++) {
+        Reactor *reactor = &server->workers[i].reactor;
+        fprintf(output, "%d,%d,%d\n", i, reactor_queue_depth(reactor),
+                reactor_connection_count(reactor));
+    }
+    fclose(output);
+    *length = size;
+    return text;
+}
+
+/**
+ * Writes the rows of latencies for one game property, merging what every
+ * thread has recorded.
+ * @param output - The stream to write to.
+ * @param server - The server instance.
+ * @param prop - The properties of the game.
+ */
+void write_prop_latency(FILE *output, Server *server, GameProp *prop) {
+    static const char *names[LATENCY_KINDS] = {"turn", "move", "handshake",
+            "start"};
+    if (prop->latency == NULL) {
+        return;
+    }
+    for (int kind = 0; kind < LATENCY_KINDS; kind++) {
+        Histogram merged;
+        memset(&merged, 0, sizeof(Histogram));
+        uint64_t count = 0;
+        for (int i = 0; i <= server->workerAmount; i++) {
+            histogram_merge(&merged, &prop->latency[i * LATENCY_KINDS + kind]);
+        }
+        for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+            count += merged.counts[i];
+        }
+        fprintf(output, "%s,%s,%lu,%lu,%lu,%lu\n", prop->port, names[kind],
+                (unsigned long) count,
+                (unsigned long) histogram_percentile(&merged, 0.5),
+                (unsigned long) histogram_percentile(&merged, 0.99),
+                (unsigned long) histogram_percentile(&merged, 0.999));
+    }
+}
+
+/**
+ * Formats a report of the latencies measured on every port since the
+ * server started. Runs on the acceptor's thread, which owns the game
+ * properties.
+ * @param server - The server instance.
+ * @param length - Set to the length of the report.
+ * @returns The report, which the caller must free.
+ */
+char *format_latency(Server *server, int *length) {
+    char *text;
+    size_t size;
+    FILE *output = open_memstream(&text, &size);
+    fprintf(output, "Port,Latency,Count,P50 Microseconds,P99 Microseconds,"
+            "P999 Microseconds\n");
+    for (int i = 0; i < server->portAmount; i++) {
+        write_prop_latency(output, server, server->gameProps[i]);
+    }
+    for (int i = 0; i < server->retiredAmount; i++) {
+        write_prop_latency(output, server, server->retiredProps[i]);
+    }
+    fclose(output);
+    *length = size;
+    return text;
+}
+
+/**
+ * A thread for sending a stats report to a connection, so that a slow
+ * reader does not hold up the acceptor.
+ * @param arg - The StatsArgs type, which is freed.
+ */
+void *stats_thread(void *arg) {
+    pthread_detach(pthread_self());
+    StatsArgs *args = (StatsArgs *) arg;
+    struct iovec segment = {args->text, args->length};
+    write_vector(args->sock, &segment, 1);
+    close(args->sock);
+    free(args->text);
+    free(args);
+    return NULL;
+}
+
+/**
+ * Reports stats or latencies to a connection which asked for them. Always
+ * run by the acceptor.
+ * @param reactor - The acceptor.
+ * @param arg - The StatsArgs type.
+ */
+void report_stats(Reactor *reactor, void *arg) {
+    StatsArgs *args = (StatsArgs *) arg;
+    if (args->type == LATENCY_CONNECT) {
+        args->text = format_latency(args->server, &args->length);
+    } else {
+        args->text = format_stats(args->server, &args->length);
+    }
+    pthread_t thread;
+    pthread_create(&thread, NULL, stats_thread, (void *) args);
+}
+
+/**
+ * Hands a connection which asked for stats or latencies to the acceptor,
+ * straight away if the handshake ran on the acceptor.
+ * @param reactor - The reactor the handshake ran on.
+ * @param server - The server instance.
+ * @param sock - The socket of the connection.
+ * @param type - STATS_CONNECT or LATENCY_CONNECT.
+ */
+void queue_stats(Reactor *reactor, Server *server, int sock,
+        enum ConnectionType type) {
+    StatsArgs *args = malloc(sizeof(StatsArgs));
+    args->server = server;
+    args->type = type;
+    args->sock = sock;
+    if (reactor == &server->acceptor) {
+        report_stats(reactor, args);
+    } else {
+        reactor_post(&server->acceptor, report_stats, args);
+    }
+}
+
+/**
+ * Sends a short reply to a connection which is still completing its
+ * handshake. Replies are small enough to always fit in a fresh socket's
+ * send buffer.
+ * @param sock - The socket to send to.
+ * @param message - The message to send.
+ */
+void send_reply(int sock, char *message) {
+    send(sock, message, strlen(message), MSG_NOSIGNAL | MSG_DONTWAIT);
+}
+
+/**
+ * Verifies a connection to the server.
+ * @param prop - The game properties.
+ * @param sock - The connection to send to.
+ * @param line - The first line recieved from the connection.
+ * @returns The connection type.
+ */
+enum ConnectionType verify_connection(GameProp *prop, int sock, char *line) {
+    enum ConnectionType type = INVALID_CONNECT;
+    if (strcmp(line, "scores") == 0) {
+        send_reply(sock, "yes\n");
+        type = SCORES_CONNECT;
+    } else if (strcmp(line, "stats") == 0) {
+        send_reply(sock, "yes\n");
+        type = STATS_CONNECT;
+    } else if (strcmp(line, "latency") == 0) {
+        send_reply(sock, "yes\n");
+        type = LATENCY_CONNECT;
+    } else if (strncmp(line, "play", strlen("play")) == 0) {
+        if (strcmp(prop->key, line + strlen("play")) != 0) {
+            send_reply(sock, "no\n");
+        } else {
+            send_reply(sock, "yes\n");
+            type = PLAYER_CONNECT;
+        }
+    } else if (strncmp(line, "reconnect", strlen("reconnect")) == 0) {
+        if (strcmp(prop->key, line + strlen("reconnect")) != 0) {
+            send_reply(sock, "no\n");
+        } else {
+            send_reply(sock, "yes\n");
+            type = PLAYER_RECONNECT;
+        }
+    }
+    return type;
+}
+
+/**
+ * Handles a player reconnecting to the server. A known reconnect id hands
+ * the socket to the worker playing the game, otherwise the player is told
+ * no and disconnected.
+ * @param server - The server instance.
+ * @param prop - The game properties.
+ * @param sock - The connection to send to.
+ * @param rid - The line sent by the player, rid then the reconnect id.
+ */
+void handle_player_reconnect(Server *server, GameProp *prop, int sock,
+        char *rid) {
+    Session session;
+    if (strncmp(rid, "rid", strlen("rid")) != 0 ||
+            !session_table_find(&server->sessions, rid + strlen("rid"),
+            &session)) {
+        send_reply(sock, "no\n");
+        close(sock);
+        return;
+    }
+    Rejoin *rejoin = malloc(sizeof(Rejoin));
+    rejoin->sessions = &server->sessions;
+    rejoin->rid = malloc(sizeof(char) * (strlen(rid) + 1));
+    strcpy(rejoin->rid, rid + strlen("rid"));
+    rejoin->sock = sock;
+    reactor_post(session.reactor, rejoin_game, rejoin);
+}
+
+/**
+ * Handles a player connecting to the server.
+ * @param server - The server instance.
+ * @param prop - The game properties.
+ * @param player - The player with its connection setup.
+ * @param gameName - The name of the game the player wants to join.
+ * @param playerName - The name of the player.
+ */
+void handle_player_connect(Server *server, GameProp *prop,
+        struct GamePlayer *player, char *gameName,
+        InternedName *playerName) {
+    GameProp *lobbyProp;
+    int index = get_avaliable_game_all(server, gameName, &lobbyProp);
+    if (index == -1) { // Game does not exist, create it.
+        index = create_new_game(prop, player, gameName, playerName,
+                &server->lock);
+        name_index_add(&server->games,
+                slab_at(&prop->instances, index)->name)->gameCount++;
+    } else { // Game exists, add to existing game.
+        // The game may be on a different port.
+        prop = lobbyProp;
+        add_to_existing_game(prop, player, playerName, index,
+                &server->lock);
+    }
+    // A reload may have lowered the amount of players since the game was
+    // created.
+    int playerCount = slab_at(&prop->instances, index)->playerCount;
+    if (prop->playerMax <= playerCount) {
+        // Everyone but the newest player was waiting in the lobby.
+        prop->waiting -= playerCount - 1;
+        play_game(server, prop, index, &server->lock);
+    } else {
+        prop->waiting++;
+        wait_for_players(server, prop, index);
+    }
+}
+
+/**
+ * Matches a player who has completed their handshake in to a game. Always
+ * run by the acceptor, which owns every game waiting for players.
+ * @param reactor - The acceptor.
+ * @param arg - The join, which is freed.
+ */
+void join_game(Reactor *reactor, void *arg) {
+    Join *join = arg;
+    struct GamePlayer player;
+    setup_player_fd(&player, join->sock);
+    handle_player_connect(join->args->server, join->args->prop, &player,
+            join->gameName, join->player);
+    free(join->gameName);
+    free(join);
+}
+
+/**
+ * Hands a player who has completed their handshake to the acceptor to be
+ * matched in to a game, straight away if the handshake ran on the acceptor.
+ * @param reactor - The reactor the handshake ran on.
+ * @param args - The server and game properties of the listening socket.
+ * @param sock - The socket of the player.
+ * @param gameName - The name of the game the player wants to join.
+ * @param playerName - The name of the player.
+ */
+void queue_join(Reactor *reactor, ServerGameArgs *args, int sock,
+        char *gameName, InternedName *playerName) {
+    Join *join = malloc(sizeof(Join));
+    join->args = args;
+    join->sock = sock;
+    join->gameName = gameName;
+    join->player = playerName;
+    Reactor *acceptor = &args->server->acceptor;
+    if (reactor == acceptor) {
+        join_game(acceptor, join);
+    } else {
+        reactor_post(acceptor, join_game, join);
+    }
+}
+
+/**
+ * Records how long a handshake took from the connection being accepted to
+ * it being handed on.
+ * @param reactor - The reactor the connection is registered with.
+ * @param handshake - The handshake.
+ */
+void record_handshake(Reactor *reactor, Handshake *handshake) {
+    GameProp *prop = handshake->args->prop;
+    histogram_record(&get_latency(handshake->args->server, prop,
+            reactor)[HANDSHAKE_LATENCY], latency_now() - handshake->accepted);
+}
+
+/**
+ * Stops tracking the handshake of a connection.
+ * @param reactor - The reactor the connection is registered with.
+ * @param connection - The connection.
+ * @param closeSocket - 1 if the connection should also be closed.
+ */
+void end_handshake(Reactor *reactor, Connection *connection,
+        int closeSocket) {
+    Handshake *handshake = connection->data;
+    reactor_disarm(reactor, &handshake->timer);
+    free(handshake->gameName);
+    free(handshake);
+    reactor_release(reactor, connection, closeSocket);
+}
+
+/**
+ * Drops a connection which has not completed its handshake in time.
+ * @param context - The reactor the connection is registered with.
+ * @param timer - The timer of the handshake.
+ */
+void handshake_expired(void *context, Timer *timer) {
+    end_handshake((Reactor *) context, timer->data, 1);
+}
+
+/**
+ * Moves a handshake on by one line.
+ * @param reactor - The reactor the connection is registered with.
+ * @param connection - The connection.
+ * @param line - The line recieved from the connection.
+ * @returns 1 if the handshake has ended and the connection was released.
+ */
+int advance_handshake(Reactor *reactor, Connection *connection, char *line) {
+    Handshake *handshake = connection->data;
+    Server *server = handshake->args->server;
+    GameProp *prop = handshake->args->prop;
+    int sock = connection->fd;
+    enum ConnectionType type;
+    switch (handshake->state) {
+        case (AWAIT_CONNECT):
+            type = verify_connection(prop, sock, line);
+            switch (type) {
+                case (PLAYER_CONNECT):
+                    handshake->state = AWAIT_GAME_NAME;
+                    return 0;
+                case (PLAYER_RECONNECT):
+                    handshake->state = AWAIT_RID;
+                    return 0;
+                case (SCORES_CONNECT): {
+                    record_handshake(reactor, handshake);
+                    end_handshake(reactor, connection, 0);
+                    ScoresArgs *args = malloc(sizeof(ScoresArgs));
+                    args->server = server;
+                    args->sock = sock;
+                    pthread_t thread;
+                    pthread_create(&thread, NULL, scores_thread,
+                            (void *) args);
+                    return 1;
+                }
+                case (STATS_CONNECT):
+                case (LATENCY_CONNECT):
+                    record_handshake(reactor, handshake);
+                    end_handshake(reactor, connection, 0);
+                    queue_stats(reactor, server, sock, type);
+                    return 1;
+                default:
+                    __atomic_fetch_add(&prop->plays.errors, 1,
+                            __ATOMIC_RELAXED);
+                    end_handshake(reactor, connection, 1);
+                    return 1;
+            }
+        case (AWAIT_GAME_NAME):
+            if (strlen(line) == 0) {
+                __atomic_fetch_add(&prop->plays.errors, 1, __ATOMIC_RELAXED);
+                end_handshake(reactor, connection, 1);
+                return 1;
+            }
+            handshake->gameName = malloc(sizeof(char) * (strlen(line) + 1));
+            strcpy(handshake->gameName, line);
+            handshake->state = AWAIT_PLAYER_NAME;
+            return 0;
+        case (AWAIT_PLAYER_NAME): {
+            if (strlen(line) == 0) {
+                __atomic_fetch_add(&prop->plays.errors, 1, __ATOMIC_RELAXED);
+                end_handshake(reactor, connection, 1);
+                return 1;
+            }
+            InternedName *playerName = intern_name(&server->players, line);
+            char *gameName = handshake->gameName;
+            handshake->gameName = NULL;
+            ServerGameArgs *args = handshake->args;
+            record_handshake(reactor, handshake);
+            end_handshake(reactor, connection, 0);
+            queue_join(reactor, args, sock, gameName, playerName);
+            return 1;
+        }
+        case (AWAIT_RID): {
+            char *rid = malloc(sizeof(char) * (strlen(line) + 1));
+            strcpy(rid, line);
+            record_handshake(reactor, handshake);
+            end_handshake(reactor, connection, 0);
+            handle_player_reconnect(server, prop, sock, rid);
+            free(rid);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Handles input on a connection which has not completed its handshake.
+ * Each complete line moves the handshake on, so a slow client only ever
+ * holds up itself.
+ * @param reactor - The reactor the connection is registered with.
+ * @param connection - The connection.
+ */
+void handle_handshake_input(Reactor *reactor, Connection *connection) {
+    char *line;
+    int ended = 0;
+    while (!ended && connection_read_line(connection, &line) != -1) {
+        ended = advance_handshake(reactor, connection, line);
+    }
+    if (!ended && (connection->closed || connection_is_full(connection))) {
+        end_handshake(reactor, connection, 1);
+    }
+}
+
+/**
+ * Starts the handshake of a newly accepted connection.
+ * @param reactor - The reactor the listener is registered with.
+ * @param listener - The listening connection.
+ * @param sock - The accepted socket.
+ */
+void accept_connection(Reactor *reactor, Connection *listener, int sock) {
+    Handshake *handshake = malloc(sizeof(Handshake));
+    handshake->args = listener->data;
+    handshake->state = AWAIT_CONNECT;
+    handshake->gameName = NULL;
+    handshake->accepted = latency_now();
+    Connection *connection = reactor_watch(reactor, sock,
+            handle_handshake_input, handshake);
+    if (connection == NULL) {
+        free(handshake);
+        close(sock);
+        return;
+    }
+    timer_init(&handshake->timer, handshake_expired, connection);
+    int timeout = get_timeout_milliseconds(handshake->args->prop);
+    if (timeout > 0) {
+        reactor_arm(reactor, &handshake->timer, timeout);
+    }
+}
+
+/**
+ * Starts one of a game property's accepting sockets on the worker which
+ * owns it. A socket which cannot be watched is closed.
+ * @param reactor - The reactor of the worker.
+ * @param arg - The ShardListen type, which is freed.
+ */
+void start_shard(Reactor *reactor, void *arg) {
+    ShardListen *listen = (ShardListen *) arg;
+    GameProp *prop = listen->prop;
+    prop->listeners[listen->shard] = reactor_listen(reactor,
+            prop->shardSockets[listen->shard], accept_connection,
+            &prop->accepts, (void *) prop->args);
+    if (prop->listeners[listen->shard] == NULL) {
+        close(prop->shardSockets[listen->shard]);
+        prop->shardSockets[listen->shard] = -1;
+    }
+    free(listen);
+}
+
+/**
+ * Stops one of a game property's accepting sockets on the worker which
+ * owns it, and closes the socket.
+ * @param reactor - The reactor of the worker.
+ * @param arg - The ShardListen type, which is freed.
+ */
+void stop_shard(Reactor *reactor, void *arg) {
+    ShardListen *listen = (ShardListen *) arg;
+    GameProp *prop = listen->prop;
+    if (prop->listeners[listen->shard] != NULL) {
+        reactor_release(reactor, prop->listeners[listen->shard], 1);
+        prop->listeners[listen->shard] = NULL;
+        prop->shardSockets[listen->shard] = -1;
+    }
+    free(listen);
+}
+
+/**
+ * Hands starting or stopping one of a game property's accepting sockets to
+ * the worker which owns it.
+ * @param server - The server instance.
+ * @param prop - The properties of the game.
+ * @param shard - The index of the socket, which is the index of its worker.
+ * @param task - start_shard or stop_shard.
+ */
+void post_shard(Server *server, GameProp *prop, int shard, Task task) {
+    ShardListen *listen = malloc(sizeof(ShardListen));
+    listen->prop = prop;
+    listen->shard = shard;
+    reactor_post(&server->workers[shard].reactor, task, listen);
+}
+
+/**
+ * Opens another socket on a port for each worker after the first which
+ * accepts connections, and registers each socket with its own worker. The
+ * kernel spreads new connections over the sockets, so handshakes run on
+ * every accepting worker at once.
+ * @param server - The server instance.
+ * @param prop - The properties of the game.
+ * @returns 0 on success, -1 if a socket could not be opened.
+ */
+int listen_on_shards(Server *server, GameProp *prop) {
+    prop->shardSockets = malloc(sizeof(int) * server->acceptorAmount);
+    prop->shardSockets[0] = prop->socket;
+    for (int i = 1; i < server->acceptorAmount; i++) {
+        if (get_socket(&prop->shardSockets[i], prop->port, 1,
+                server->backlog)) {
+            for (int j = 1; j < i; j++) {
+                close(prop->shardSockets[j]);
+            }
+            return -1;
         }
     }
-    return index;
+    for (int i = 0; i < server->acceptorAmount; i++) {
+        post_shard(server, prop, i, start_shard);
+    }
+    return 0;
 }
 
 /**
- * Gets the index of a non full game with a particulat name on
- * all game properties (i.e all ports).
+ * Starts accepting players for a game property, either on the acceptor or
+ * spread over the workers. Runs on the acceptor's thread.
  * @param server - The server instance.
- * @param name - The name of the game.
- * @param portOut - The port the game exists on.
- * @returns The index of the game, -1 if the game does not exist.
+ * @param prop - The properties of the game.
+ * @returns 0 on success, -1 on failure.
  */
-int get_avaliable_game_all(Server *server, char *name, char **portOut) {
-    int index = -1;
-    for (int i = 0; i < server->portAmount; i++) {
-        index = get_avaliable_game(&server->gameProps[i], name);
-        if (index != -1) {
-            *portOut = server->gameProps[i].port;
-            break;
+int listen_on_prop(Server *server, GameProp *prop) {
+    setup_latency(server, prop);
+    prop->args = malloc(sizeof(ServerGameArgs));
+    prop->args->server = server;
+    prop->args->prop = prop;
+    prop->listeners = calloc(server->acceptorAmount, sizeof(Connection *));
+    if (server->acceptorAmount > 1) {
+        return listen_on_shards(server, prop);
+    }
+    prop->listeners[0] = reactor_listen(&server->acceptor, prop->socket,
+            accept_connection, &prop->accepts, (void *) prop->args);
+    return prop->listeners[0] == NULL ? -1 : 0;
+}
+
+/**
+ * Sets up the latency histograms of a game property, one set for the
+ * acceptor and one for each worker so every thread records in its own.
+ * Workers are always setup by the time a property starts to listen.
+ * @param server - The server instance.
+ * @param prop - The properties of the game.
+ */
+void setup_latency(Server *server, GameProp *prop) {
+    prop->latency = calloc((server->workerAmount + 1) * LATENCY_KINDS,
+            sizeof(Histogram));
+}
+
+/**
+ * Gets the latency histograms a thread records in for a game property.
+ * @param server - The server instance.
+ * @param prop - The properties of the game.
+ * @param reactor - The reactor of the thread, the acceptor or a worker's.
+ * @returns The histograms, indexed by the kind of latency.
+ */
+Histogram *get_latency(Server *server, GameProp *prop, Reactor *reactor) {
+    int thread = 0;
+    if (reactor != &server->acceptor) {
+        Worker *worker = (Worker *) ((char *) reactor -
+                offsetof(Worker, reactor));
+        thread = worker - server->workers + 1;
+    }
+    return &prop->latency[thread * LATENCY_KINDS];
+}
+
+/**
+ * Stops a game property accepting players and closes its sockets. Players
+ * part way through their handshake and games already made keep using the
+ * properties. Runs on the acceptor's thread.
+ * @param server - The server instance.
+ * @param prop - The properties of the game.
+ */
+void stop_listening(Server *server, GameProp *prop) {
+    if (server->acceptorAmount > 1) {
+        for (int i = 0; i < server->acceptorAmount; i++) {
+            post_shard(server, prop, i, stop_shard);
         }
+    } else if (prop->listeners[0] != NULL) {
+        reactor_release(&server->acceptor, prop->listeners[0], 1);
+        prop->listeners[0] = NULL;
     }
-    return index;
+    prop->socket = -1;
 }
 
 /**
- * Gets the properties of a game based on the port.
- * all game properties (i.e all ports).
+ * Gets the path of a file in the journal directory.
  * @param server - The server instance.
- * @param port - The port to retrieve game properties from.
- * @returns The game properties associated with the port, NULL if none found.
+ * @param name - The name of the file.
+ * @returns The path, which must be freed.
  */
-GameProp *get_prop_by_port(Server *server, char *port) {
+char *get_journal_path(Server *server, char *name) {
+    char *path = malloc(sizeof(char) * (strlen(server->journalPath) +
+            strlen(name) + 2));
+    sprintf(path, "%s/%s", server->journalPath, name);
+    return path;
+}
+
+/**
+ * Gets the epoch of a file in the journal directory if it is a shard.
+ * @param name - The name of the file.
+ * @param epoch - Where to store the epoch.
+ * @returns 1 if the file is a shard.
+ */
+int get_shard_epoch(char *name, long *epoch) {
+    int worker;
+    int length = 0;
+    sscanf(name, "shard%ld.%d.journal%n", epoch, &worker, &length);
+    return length > 0 && name[length] == '\0';
+}
+
+/**
+ * Gets the game a journal record is about.
+ * @param recovery - The recovery in progress.
+ * @param serial - The serial of the game.
+ * @returns The game, NULL if its start was never journaled.
+ */
+JournaledGame *find_journaled_game(Recovery *recovery, long serial) {
+    if (serial < 0 || serial >= recovery->gameCapacity) {
+        return NULL;
+    }
+    return recovery->games[serial];
+}
+
+/**
+ * Adds a game whose start has been read from the journal.
+ * @param recovery - The recovery in progress.
+ * @param serial - The serial of the game.
+ * @param journaled - The game.
+ */
+void add_journaled_game(Recovery *recovery, long serial,
+        JournaledGame *journaled) {
+    if (serial >= recovery->gameCapacity) {
+        long capacity = max(recovery->gameCapacity * 2, serial + 1);
+        recovery->games = realloc(recovery->games,
+                sizeof(JournaledGame *) * capacity);
+        for (long i = recovery->gameCapacity; i < capacity; i++) {
+            recovery->games[i] = NULL;
+        }
+        recovery->gameCapacity = capacity;
+    }
+    recovery->games[serial] = journaled;
+}
+
+/**
+ * Frees a game read from the journal.
+ * @param journaled - The game.
+ */
+void free_journaled_game(JournaledGame *journaled) {
+    for (int i = 0; i < journaled->playerCount; i++) {
+        free(journaled->playerNames[i]);
+    }
+    for (int i = 0; i < journaled->moveCount; i++) {
+        free(journaled->moves[i]);
+    }
+    free(journaled->playerNames);
+    free(journaled->moves);
+    free(journaled->movePlayers);
+    free(journaled->name);
+    free(journaled);
+}
+
+/**
+ * Copies the text at the end of a journal record.
+ * @param record - The record.
+ * @param offset - Where the fields before the text end.
+ * @returns The copy, NULL if the record has no text.
+ */
+char *copy_record_text(char *record, int offset) {
+    if (offset == 0 || record[offset] != ' ') {
+        return NULL;
+    }
+    char *text = malloc(sizeof(char) * (strlen(record + offset) + 1));
+    strcpy(text, record + offset + 1);
+    return text;
+}
+
+/**
+ * Finds the game properties a game was journaled with. Properties given a
+ * port are found on it, while those given any port are listening somewhere
+ * new after a restart, so the game goes to the first of them which seats as
+ * many players as it had.
+ * @param server - The server instance.
+ * @param port - The port from the statfile the game was journaled with.
+ * @param playerCount - The amount of players in the game.
+ * @returns The properties, NULL if none match.
+ */
+GameProp *get_journaled_prop(Server *server, char *port, int playerCount) {
+    if (strcmp(port, "0") != 0) {
+        return get_prop_by_port(server, port);
+    }
     for (int i = 0; i < server->portAmount; i++) {
-        if (strcmp(server->gameProps[i].port, port) == 0) {
-            return &server->gameProps[i];
+        GameProp *prop = server->gameProps[i];
+        if (prop->anyPort && prop->playerMax == playerCount) {
+            return prop;
         }
     }
     return NULL;
 }
 
 /**
- * Gets the index of a player in a given score table based on the player name.
- * @param table - The score table to parse..
- * @param playerName - The name of the player.
- * @returns The index of the player, -1 if the player does not exist.
+ * Reads the start of a game back from the journal. Games created since
+ * restore the count of games with their name, so reconnect IDs stay
+ * unique.
+ * @param recovery - The recovery in progress.
+ * @param record - The record.
+ */
+void recover_start(Recovery *recovery, char *record) {
+    Server *server = recovery->server;
+    long serial;
+    char port[JOURNAL_PORT_SIZE];
+    int gameCounter, playerCount;
+    int offset = 0;
+    sscanf(record, "S %ld %5s %d %d%n", &serial, port, &gameCounter,
+            &playerCount, &offset);
+    char *name = copy_record_text(record, offset);
+    if (name == NULL || serial < 0 || playerCount <= 0 ||
+            playerCount > MAX_PLAYERS) {
+        free(name);
+        return;
+    }
+    GameProp *prop = get_journaled_prop(server, port, playerCount);
+    if (prop == NULL) {
+        free(name);
+        return;
+    }
+    NameEntry *entry = name_index_add(&server->games, name);
+    entry->gameCount = max(entry->gameCount, gameCounter);
+    JournaledGame *journaled = malloc(sizeof(JournaledGame));
+    journaled->prop = prop;
+    journaled->gameCounter = gameCounter;
+    journaled->playerCount = playerCount;
+    journaled->name = name;
+    journaled->playerNames = calloc(playerCount, sizeof(char *));
+    journaled->moveCount = 0;
+    journaled->moveCapacity = 0;
+    journaled->movePlayers = NULL;
+    journaled->moves = NULL;
+    add_journaled_game(recovery, serial, journaled);
+}
+
+/**
+ * Reads a player or a move of a game back from the journal.
+ * @param recovery - The recovery in progress.
+ * @param record - The record.
+ */
+void recover_player_or_move(Recovery *recovery, char *record) {
+    long serial;
+    int playerId;
+    int offset = 0;
+    sscanf(record + 1, " %ld %d%n", &serial, &playerId, &offset);
+    JournaledGame *journaled = find_journaled_game(recovery, serial);
+    char *text = copy_record_text(record + 1, offset);
+    if (journaled == NULL || text == NULL || playerId < 0 ||
+            playerId >= journaled->playerCount) {
+        free(text);
+        return;
+    }
+    if (record[0] == 'P') {
+        free(journaled->playerNames[playerId]);
+        journaled->playerNames[playerId] = text;
+        return;
+    }
+    if (journaled->moveCount == journaled->moveCapacity) {
+        journaled->moveCapacity = max(journaled->moveCapacity * 2, 16);
+        journaled->moves = realloc(journaled->moves,
+                sizeof(char *) * journaled->moveCapacity);
+        journaled->movePlayers = realloc(journaled->movePlayers,
+                sizeof(int) * journaled->moveCapacity);
+    }
+    journaled->moves[journaled->moveCount] = text;
+    journaled->movePlayers[journaled->moveCount++] = playerId;
+}
+
+/**
+ * Reads the end of a game back from the journal. The game is replayed
+ * straight away so its scores are counted, then forgotten.
+ * @param recovery - The recovery in progress.
+ * @param record - The record.
+ */
+void recover_end(Recovery *recovery, char *record) {
+    long serial = -1;
+    sscanf(record, "E %ld", &serial);
+    JournaledGame *journaled = find_journaled_game(recovery, serial);
+    if (journaled == NULL) {
+        return;
+    }
+    GameRun *run = replay_game(recovery->server, journaled, NULL);
+    if (run != NULL) {
+        discard_replay(run);
+    }
+    free_journaled_game(journaled);
+    recovery->games[serial] = NULL;
+}
+
+/**
+ * Reads one record back from the journal.
+ * @param arg - The Recovery type.
+ * @param record - The record.
  */
-int index_of_player_in_table(ScoreTable table, char *playerName) {
-    int index = -1;
-    for (int i = 0; i < table.entryCount; i++) {
-        if (strcmp(table.entries[i].playerName, playerName) == 0) {
-            index = i;
+void read_journal_record(void *arg, char *record) {
+    Recovery *recovery = (Recovery *) arg;
+    int tokensTaken, pointsEarned;
+    int offset = 0;
+    char *name;
+    switch (record[0]) {
+        case 'C':
+            sscanf(record, "C %ld", &recovery->epoch);
+            break;
+        case 'T':
+            sscanf(record, "T %d %d%n", &tokensTaken, &pointsEarned,
+                    &offset);
+            name = copy_record_text(record, offset);
+            if (name != NULL) {
+                leaderboard_add(&recovery->server->leaderboard,
+                        intern_name(&recovery->server->players, name),
+                        tokensTaken, pointsEarned);
+                free(name);
+            }
+            break;
+        case 'S':
+            recover_start(recovery, record);
             break;
+        case 'P':
+        case 'M':
+            recover_player_or_move(recovery, record);
+            break;
+        case 'E':
+            recover_end(recovery, record);
+            break;
+    }
+}
+
+/**
+ * Rebuilds a game from the journal by playing its moves again on a fresh
+ * instance. Nothing is sent, but scores are counted as the moves are
+ * played. Replaying stops at the first move which no longer plays, which
+ * only happens if the deckfile or statfile has changed.
+ * @param server - The server instance.
+ * @param journaled - The game read from the journal.
+ * @param journal - Where to journal the game again under a new serial,
+ * NULL to not journal it.
+ * @returns The game, NULL if the journal did not say who played it.
+ */
+GameRun *replay_game(Server *server, JournaledGame *journaled,
+        Journal *journal) {
+    for (int i = 0; i < journaled->playerCount; i++) {
+        if (journaled->playerNames[i] == NULL) {
+            return NULL;
         }
     }
-    return index;
+    GameProp *prop = journaled->prop;
+    int index = add_instance(prop);
+    struct Game *game = slab_at(&prop->instances, index);
+    Arena *arena = slab_arena(&prop->instances, index);
+    *game = setup_instance(arena, journaled->name, prop->startToken,
+            prop->winPoints);
+    for (int i = 0; i < journaled->playerCount; i++) {
+        struct GamePlayer player;
+        setup_player_fd(&player, -1);
+        setup_player(&player, i,
+                intern_name(&server->players, journaled->playerNames[i]));
+        add_player(game, &player, arena, &server->lock);
+    }
+    setup_scores_table(prop, game);
+    GameRun *run = arena_alloc(arena, sizeof(GameRun));
+    run->prop = prop;
+    run->deck = shared_deck_acquire(server->deck);
+    run->deckCursor = 0;
+    run->slot = index;
+    run->game = game;
+    run->arena = arena;
+    run->gameCounter = journaled->gameCounter;
+    run->connections = NULL;
+    run->dropTimers = NULL;
+    run->sessions = &server->sessions;
+    run->journal = journal;
+    run->serial = journal == NULL ? -1 : server->journalSerial++;
+    run->latency = NULL;
+    outbox_init(&run->outbox, game->playerCount, arena);
+    journal_game(run);
+    refill_board(run);
+    run->currentPlayer = 0;
+    run->attempts = 0;
+    for (int i = 0; i < journaled->moveCount; i++) {
+        int playerId = journaled->movePlayers[i];
+        if (playerId != run->currentPlayer ||
+                do_what(run, playerId, journaled->moves[i])) {
+            break;
+        }
+        journal_move(run, playerId, journaled->moves[i]);
+        refill_board(run);
+        run->currentPlayer = (playerId + 1) % game->playerCount;
+        // With no connections attached, flushing throws the output away.
+        outbox_flush(&run->outbox);
+    }
+    run->journal = NULL;
+    return run;
+}
+
+/**
+ * Frees a replayed game which is already over.
+ * @param run - The replayed game.
+ */
+void discard_replay(GameRun *run) {
+    shared_deck_release(run->deck);
+    reap_instance(run->prop, run->slot);
+}
+
+/**
+ * Carries on playing a game recovered from the journal. Runs on the
+ * worker's thread. Every player starts out dropped, and has the reconnect
+ * window to come back with their reconnect ID.
+ * @param reactor - The reactor of the worker.
+ * @param arg - The GameRun type.
+ */
+void resume_game(Reactor *reactor, void *arg) {
+    GameRun *run = (GameRun *) arg;
+    struct Game *game = run->game;
+    setup_game_timers(run);
+    run->connections = arena_alloc(run->arena,
+            sizeof(Connection *) * game->playerCount);
+    memset(run->connections, 0, sizeof(Connection *) * game->playerCount);
+    for (int i = 0; i < game->playerCount; i++) {
+        outbox_attach(&run->outbox, reactor, i, NULL);
+        reactor_arm(reactor, &run->dropTimers[i],
+                run->prop->reconnectWindow * 1000);
+    }
+    add_sessions(run, reactor);
+    if (run->currentPlayer == 0 && is_game_over(game)) {
+        end_game(reactor, run, END_OF_GAME, 0);
+        return;
+    }
+    await_move(reactor, run);
+    flush_game(reactor, run);
 }
 
 /**
- * Combines all scores on a server and sends it to a file descriptor.
+ * Deletes every shard in the journal directory which is not from an epoch.
  * @param server - The server instance.
- * @param toConnection - The connection to send to.
+ * @param keepEpoch - The epoch to keep, -1 to delete every shard.
  */
-void combine_all_scores_and_send(Server *server, FILE *toConnection) {
-    ScoreTable table;
-    table.entryCount = 0;
-    table.entries = malloc(0);
-    for (int i = 0; i < server->portAmount; i++) {
-        for (int j = 0; j < server->gameProps[i].scoresTable.entryCount;
-                j++) {
-            ScoreEntry entry = server->gameProps[i].scoresTable.entries[j];
-            int index = index_of_player_in_table(table, entry.playerName);
-            if (index == -1) {
-                table.entries = realloc(table.entries, sizeof(ScoreEntry) *
-                        (table.entryCount + 1));
-                table.entries[table.entryCount] = entry;
-                table.entryCount++;
-            } else {
-                table.entries[index].tokensTaken += entry.tokensTaken;
-                table.entries[index].pointsEarned += entry.pointsEarned;
-            }
+void remove_shard_journals(Server *server, long keepEpoch) {
+    DIR *directory = opendir(server->journalPath);
+    if (directory == NULL) {
+        return;
+    }
+    struct dirent *file;
+    long epoch;
+    while ((file = readdir(directory)) != NULL) {
+        if (get_shard_epoch(file->d_name, &epoch) && epoch != keepEpoch) {
+            char *path = get_journal_path(server, file->d_name);
+            unlink(path);
+            free(path);
         }
     }
-    send_message(toConnection, "Player Name,Total Tokens,Total Points\n");
-    for (int i = 0; i < table.entryCount; i++) {
-        ScoreEntry s = table.entries[i];
-        send_message(toConnection, "%s,%i,%i\n", s.playerName,
-                s.tokensTaken, s.pointsEarned);
+    closedir(directory);
+}
+
+/**
+ * Reads back every shard from the epoch of the checkpoint. Shards from any
+ * other epoch were already folded in to the checkpoint.
+ * @param recovery - The recovery in progress.
+ */
+void read_shard_journals(Recovery *recovery) {
+    DIR *directory = opendir(recovery->server->journalPath);
+    if (directory == NULL) {
+        return;
+    }
+    struct dirent *file;
+    long epoch;
+    while ((file = readdir(directory)) != NULL) {
+        if (get_shard_epoch(file->d_name, &epoch) &&
+                epoch == recovery->epoch) {
+            char *path = get_journal_path(recovery->server, file->d_name);
+            journal_read(path, read_journal_record, recovery);
+            free(path);
+        }
     }
-    free(table.entries);
+    closedir(directory);
 }
 
 /**
- * Verifies a connection to the server.
- * @param prop - The game properties.
- * @param toConnection - The connection to send to.
- * @param fromConnection - The connection to recieve from.
- * @returns The connection type.
+ * Journals the totals of every player on the leaderboard, in the order the
+ * players were first seen.
+ * @param journal - The journal to write to.
+ * @param board - The leaderboard.
  */
-enum ConnectionType verify_connection(GameProp *prop, FILE *toConnection,
-        FILE *fromConnection) {
-    enum ConnectionType type;
-    char *buffer;
-    read_line(fromConnection, &buffer, 0);
-    if (strcmp(buffer, "scores") == 0) {
-        send_message(toConnection, "yes\n");
-        type = SCORES_CONNECT;
-    } else if (strstr(buffer, "play") != NULL) {
-        char **encoded = split(buffer, "y");
-        if (strcmp(prop->key, encoded[RIGHT]) != 0) {
-            send_message(toConnection, "no\n");
-            type = INVALID_CONNECT;
-        } else {
-            send_message(toConnection, "yes\n");
-            type = PLAYER_CONNECT;
+void journal_scores(Journal *journal, Leaderboard *board) {
+    ScoreEntry *entries;
+    int count = score_table_collect(&board->totals, &entries);
+    for (int i = 0; i < count; i++) {
+        journal_record(journal, "T %d %d %s", entries[i].tokensTaken,
+                entries[i].pointsEarned, entries[i].player->name);
+    }
+    free(entries);
+}
+
+/**
+ * Opens a fresh shard of the current epoch for every worker, which commits
+ * it once per loop.
+ * @param server - The server instance.
+ */
+void open_journals(Server *server) {
+    for (int i = 0; i < server->workerAmount; i++) {
+        char name[MESSAGE_BUFFER_SIZE];
+        snprintf(name, MESSAGE_BUFFER_SIZE, JOURNAL_SHARD_FORMAT,
+                server->journalEpoch, i);
+        char *path = get_journal_path(server, name);
+        Journal *journal = malloc(sizeof(Journal));
+        if (journal_open(journal, path, 1, server->journalSync) == -1) {
+            exit_with_error(SYSTEM_ERR);
         }
-        free(encoded);
-    } else if (strstr(buffer, "reconnect") != NULL) {
-        char **encoded = split(buffer, "t");
-        if (strcmp(prop->key, encoded[RIGHT]) != 0) {
-            send_message(toConnection, "no\n");
-            type = INVALID_CONNECT;
-        } else {
-            send_message(toConnection, "yes\n");
-            type = PLAYER_RECONNECT;
+        free(path);
+        server->workers[i].journal = journal;
+        server->workers[i].reactor.idle = commit_journal;
+        server->workers[i].reactor.idleArg = journal;
+    }
+}
+
+/**
+ * Rebuilds the scores and every unfinished game from the journal. Finished
+ * games are replayed as they are read, then everything still needed is
+ * written to a new checkpoint under the next epoch, so the old shards can
+ * be thrown away. Unfinished games are handed back to the workers, and
+ * their players can reconnect with the reconnect IDs they were given.
+ * @param server - The server instance.
+ */
+void recover_journal(Server *server) {
+    Recovery recovery;
+    recovery.server = server;
+    recovery.epoch = 0;
+    recovery.gameCapacity = 0;
+    recovery.games = NULL;
+    char *checkpointPath = get_journal_path(server, JOURNAL_CHECKPOINT);
+    char *tempPath = get_journal_path(server, JOURNAL_CHECKPOINT_TEMP);
+    journal_read(checkpointPath, read_journal_record, &recovery);
+    read_shard_journals(&recovery);
+    server->journalEpoch = recovery.epoch + 1;
+    Journal checkpoint;
+    if (journal_open(&checkpoint, tempPath, 1, 1) == -1) {
+        exit_with_error(SYSTEM_ERR);
+    }
+    journal_record(&checkpoint, "C %ld", server->journalEpoch);
+    // Totals are taken before unfinished games add to them again.
+    journal_scores(&checkpoint, &server->leaderboard);
+    GameRun **resumed = malloc(sizeof(GameRun *) * recovery.gameCapacity);
+    int resumedCount = 0;
+    for (long i = 0; i < recovery.gameCapacity; i++) {
+        JournaledGame *journaled = recovery.games[i];
+        if (journaled == NULL) {
+            continue;
+        }
+        GameRun *run = replay_game(server, journaled, &checkpoint);
+        if (run != NULL) {
+            resumed[resumedCount++] = run;
         }
-        free(encoded);
+        free_journaled_game(journaled);
     }
-    free(buffer);
-    return type;
+    free(recovery.games);
+    journal_close(&checkpoint);
+    if (rename(tempPath, checkpointPath) == -1) {
+        exit_with_error(SYSTEM_ERR);
+    }
+    free(tempPath);
+    free(checkpointPath);
+    remove_shard_journals(server, server->journalEpoch);
+    open_journals(server);
+    for (int i = 0; i < resumedCount; i++) {
+        Worker *worker = next_worker(server, &server->lock);
+        resumed[i]->journal = worker->journal;
+        resumed[i]->latency = get_latency(server, resumed[i]->prop,
+                &worker->reactor);
+        reactor_post(&worker->reactor, resume_game, resumed[i]);
+    }
+    free(resumed);
 }
 
 /**
- * Handles a player reconnecting to the server.
+ * Sets up the journal if one has been asked for. Unless recovery has been
+ * asked for too, anything left from before is thrown away.
  * @param server - The server instance.
- * @param prop - The game properties.
- * @param toConnection - The connection to send to.
- * @param fromConnection - The connection to recieve from.
- * @param sock - The port socket.
- * @param gamePropLock - Mutex to prevent game properties from being modified.
- */
-void handle_player_reconnect(Server *server, GameProp *prop,
-        FILE *toConnection, FILE *fromConnection, int sock,
-        pthread_mutex_t gamePropLock) {
-    struct GamePlayer player;
-    player.fileDescriptor = sock;
-    player.toPlayer = toConnection;
-    player.fromPlayer = fromConnection;
-    char *buffer;
-    if (read_line(player.fromPlayer, &buffer, 0) <= 0) {
-        fclose(player.toPlayer);
-        fclose(player.fromPlayer);
-        free(buffer);
+ */
+void setup_journal(Server *server) {
+    if (server->journalPath == NULL) {
         return;
     }
-    // Add player to game.
-    send_message(player.toPlayer, "no\n");
-    fclose(player.toPlayer);
-    fclose(player.fromPlayer);
-    free(buffer);
+    mkdir(server->journalPath, 0755);
+    if (get_setting(RECOVER_ENV, 0)) {
+        recover_journal(server);
+        return;
+    }
+    char *checkpointPath = get_journal_path(server, JOURNAL_CHECKPOINT);
+    unlink(checkpointPath);
+    free(checkpointPath);
+    remove_shard_journals(server, -1);
+    open_journals(server);
 }
 
 /**
- * Handles a player connecting to the server.
+ * Finds the game property a statfile entry describes after a reload. An
+ * entry with a port keeps the properties already on that port, and each
+ * entry without one keeps the next properties which were also given any
+ * port.
  * @param server - The server instance.
- * @param prop - The game properties.
- * @param toConnection - The connection to send to.
- * @param fromConnection - The connection to recieve from.
- * @param sock - The port socket.
- * @param gamePropLock - Mutex to prevent game properties from being modified.
+ * @param stat - The statfile entry.
+ * @param kept - Which properties have already been kept.
+ * @returns The index of the properties, -1 if the entry is new.
  */
-void handle_player_connect(Server *server, GameProp *prop, FILE *toConnection,
-        FILE *fromConnection, int sock, pthread_mutex_t gamePropLock) {
-    struct GamePlayer player;
-    player.fileDescriptor = sock;
-    player.toPlayer = toConnection;
-    player.fromPlayer = fromConnection;
-    char *buffer;
-    if (read_line(player.fromPlayer, &buffer, 0) <= 0) {
-        fclose(player.toPlayer);
-        fclose(player.fromPlayer);
-        free(buffer);
+int find_reloaded_prop(Server *server, Stat stat, int *kept) {
+    int anyPort = strcmp(stat.port, "0") == 0;
+    for (int i = 0; i < server->portAmount; i++) {
+        GameProp *prop = server->gameProps[i];
+        if (!kept[i] && prop->anyPort == anyPort &&
+                (anyPort || strcmp(prop->port, stat.port) == 0)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Reloads the deckfile and statfile without stopping any game. Games which
+ * have started keep the deck and settings they started with. Properties
+ * still in the statfile take their new settings for games made from now
+ * on, new entries start listening on their port and properties no longer
+ * in the statfile stop accepting players, though their games play on. A
+ * file which is invalid is left as it was. Runs on the acceptor's thread.
+ * @param server - The server instance.
+ */
+void reload_server(Server *server) {
+    SharedDeck *deck = read_deckfile(server->deckfilePath);
+    if (deck == NULL) {
+        report_error(INVALID_DECKFILE);
+    } else {
+        shared_deck_release(server->deck);
+        server->deck = deck;
+    }
+    StatFileProp stats;
+    if (read_statfile(server->statfilePath, &stats) == -1) {
+        report_error(INVALID_STATFILE);
         return;
     }
-    char *port;
-    int diffPort = 0;
-    int index = get_avaliable_game_all(server, buffer, &port);
-    if (index == -1) { // Game does not exist, create it.
-        create_new_game(prop, &player, buffer, &gamePropLock);
-        index = prop->instanceSize - 1;
-    } else { // Game exists, add to existing game.
-        free(buffer);
-        if (strcmp(prop->port, port) != 0) {
-            add_to_existing_game(get_prop_by_port(server, port), &player,
-                    index, &gamePropLock);
-            diffPort = 1;
+    GameProp **props = malloc(sizeof(GameProp *) * stats.amount);
+    int amount = 0;
+    int *kept = calloc(server->portAmount + 1, sizeof(int));
+    for (int i = 0; i < stats.amount; i++) {
+        int index = find_reloaded_prop(server, stats.stats[i], kept);
+        GameProp *prop;
+        if (index != -1) {
+            kept[index] = 1;
+            prop = server->gameProps[index];
+            update_game_prop(prop, stats.stats[i]);
         } else {
-            add_to_existing_game(prop, &player, index, &gamePropLock);
+            enum Error err = create_game_prop(server, stats.stats[i], &prop);
+            if (!err && listen_on_prop(server, prop) == -1) {
+                close(prop->socket);
+                free_game_prop(prop);
+                err = FAILED_LISTEN;
+            }
+            if (err) {
+                report_error(err);
+                continue;
+            }
         }
+        props[amount++] = prop;
     }
-    if (!diffPort) { // Game not on a different port, play the game.
-        if (prop->playerMax == prop->instances[index].playerCount) {
-            play_game(server, prop, index, &gamePropLock);
-        }
-    } else { // Game on a different port? Get proprties of the other port.
-        if (prop->playerMax == get_prop_by_port(server, port)
-                ->instances[index].playerCount) {
-            play_game(server, get_prop_by_port(server, port), index,
-                    &gamePropLock);
+    for (int i = 0; i < server->portAmount; i++) {
+        if (!kept[i]) {
+            stop_listening(server, server->gameProps[i]);
+            server->retiredProps = realloc(server->retiredProps,
+                    sizeof(GameProp *) * (server->retiredAmount + 1));
+            server->retiredProps[server->retiredAmount++] =
+                    server->gameProps[i];
         }
     }
+    free(kept);
+    free(server->gameProps);
+    server->gameProps = props;
+    server->portAmount = amount;
+    for (int i = 0; i < stats.amount; i++) {
+        free(stats.stats[i].port);
+    }
+    free(stats.stats);
+    print_ports(server);
 }
 
 /**
- * Handle a connection to the server
- * @param server - The server instance.
- * @param prop - The game properties.
- * @param sock - The socket to accept connections on.
- */
-void handle_connection(Server *server, GameProp *prop, int sock) {
-    pthread_mutex_t gamePropLock = PTHREAD_MUTEX_INITIALIZER;
-    FILE *toConnection = fdopen(sock, "w");
-    FILE *fromConnection = fdopen(sock, "r");
-    enum ConnectionType type = verify_connection(prop, toConnection,
-            fromConnection);
-    switch(type) {
-        case (PLAYER_CONNECT):
-            handle_player_connect(server, prop, toConnection, fromConnection,
-                    sock, gamePropLock);
-            break;
-        case (SCORES_CONNECT):
-            combine_all_scores_and_send(server, toConnection);
-            fclose(toConnection);
-            fclose(fromConnection);
-            break;
-        case (PLAYER_RECONNECT):
-            handle_player_reconnect(server, prop, toConnection,
-                    fromConnection, sock, gamePropLock);
-            break;
-        case (INVALID_CONNECT):
-            fclose(toConnection);
-            fclose(fromConnection);
-            break;
+ * Reloads the server once per SIGHUP, and stops the acceptor once SIGINT
+ * is caught. Runs once per loop of the acceptor.
+ * @param reactor - The acceptor reactor.
+ * @param arg - The Server type.
+ */
+void check_signals(Reactor *reactor, void *arg) {
+    Server *server = (Server *) arg;
+    if (server->stopWanted) {
+        reactor->running = 0;
+        return;
+    }
+    if (server->reloadWanted) {
+        server->reloadWanted = 0;
+    server->stopWanted = 0;
+        reload_server(server);
     }
 }
 
 /**
- * A thread for listening for connections on a particular port.
- * @param argv - ServerGameArgs type for passing multiple structs to a
- * thread.
+ * Starts the server by registering every game socket, either with the
+ * acceptor or spread over the workers, and running the acceptor.
+ * @param server - The server instance.
  */
-void *listen_thread(void *argv) {
-    pthread_detach(pthread_self());
-    ServerGameArgs *args = (ServerGameArgs *) argv;
-    Server *server = args->server;
-    GameProp *prop = args->prop;
-    //printf("%s %i\n", prop->port, prop->socket);
-    //printf("LISTENER THREAD %i STARTED\n", (int) pthread_self());
-    struct sockaddr_in in;
-    socklen_t size = sizeof(in);
-    while(1) {
-        int sock = accept(prop->socket, (struct sockaddr *) &in, &size);
-        if (sock == -1) {
+void start_server(Server *server) {
+    if (reactor_init(&server->acceptor, server->backend) == -1) {
+        exit_with_error(SYSTEM_ERR);
+    }
+    setup_workers(server);
+    for (int i = 0; i < server->portAmount; i++) {
+        if (listen_on_prop(server, server->gameProps[i]) == -1) {
             exit_with_error(FAILED_LISTEN);
         }
-        handle_connection(server, prop, sock);
     }
-    return NULL;
+    server->acceptor.idle = check_signals;
+    server->acceptor.idleArg = server;
+    setup_reload_handler();
+    setup_journal(server);
+    start_workers(server);
+    reactor_run(&server->acceptor);
+    stop_server(server);
+    reactor_free(&server->acceptor);
 }
 
 /**
- * Starts the server by creating listener threads.
+ * Stops every worker once the acceptor has stopped, waiting for each to
+ * close its journal, then closes every port.
  * @param server - The server instance.
  */
-void start_server(Server *server) {
-    ServerGameArgs *argList = malloc(sizeof(ServerGameArgs) *
-            server->portAmount);
-    for (int i = 0; i < server->portAmount; i++) {
-        ServerGameArgs args;
-        args.server = server;
-        args.prop = &server->gameProps[i];
-        argList[i] = args;
-        pthread_create(&server->gameProps[i].mainThread, NULL, listen_thread,
-                (void *) &argList[i]);
+void stop_server(Server *server) {
+    printf("SIGINT CAUGHT\n");
+    for (int i = 0; i < server->workerAmount; i++) {
+        reactor_post(&server->workers[i].reactor, stop_worker,
+                &server->workers[i]);
+    }
+    for (int i = 0; i < server->workerAmount; i++) {
+        pthread_join(server->workers[i].thread, NULL);
     }
     for (int i = 0; i < server->portAmount; i++) {
-        pthread_join(server->gameProps[i].mainThread, NULL);
+        GameProp *prop = server->gameProps[i];
+        close(prop->socket);
+        for (int j = 1; prop->shardSockets != NULL &&
+                j < server->acceptorAmount; j++) {
+            close(prop->shardSockets[j]);
+        }
+    }
+}
+
+/**
+ * Reads which backend the reactors should use from the environment. Only
+ * "uring" selects io_uring, anything else keeps epoll.
+ * @returns The backend to use.
+ */
+enum ReactorBackend get_backend_setting(void) {
+    char *value = getenv(BACKEND_ENV);
+    if (value != NULL && strcmp(value, "uring") == 0) {
+        return REACTOR_URING;
     }
-    free(argList);
+    return REACTOR_EPOLL;
 }
 
 /**
@@ -993,7 +2650,92 @@ void start_server(Server *server) {
  */
 void setup_server(Server *server) {
     server->portAmount = 0;
-    server->deckSize = 0;
+    server->gameProps = NULL;
+    server->retiredAmount = 0;
+    server->retiredProps = NULL;
+    server->key = NULL;
+    server->reloadWanted = 0;
+    server->stopWanted = 0;
+    // A SIGINT before the acceptor is set up has nothing to wake, and is
+    // seen once the acceptor first runs.
+    server->acceptor.wake = -1;
+    server->deck = NULL;
+    server->highWater = get_setting(HIGH_WATER_ENV, REACTOR_HIGH_WATER);
+    server->backend = get_backend_setting();
+    server->acceptorAmount = get_setting(ACCEPTORS_ENV, 1);
+    server->backlog = get_setting(BACKLOG_ENV, SOMAXCONN);
+    server->reconnectWindow = get_setting(RECONNECT_ENV, RECONNECT_WINDOW);
+    server->journalPath = getenv(JOURNAL_ENV);
+    if (server->journalPath != NULL && *server->journalPath == '\0') {
+        server->journalPath = NULL;
+    }
+    server->journalSync = get_setting(JOURNAL_SYNC_ENV, 0) != 0;
+    server->journalEpoch = 0;
+    server->journalSerial = 0;
+    server->workerAmount = 0;
+    server->startTime = get_milliseconds();
+    server->statsTime = server->startTime;
+    server->statsMoves = 0;
+    pthread_mutex_init(&server->lock, NULL);
+    leaderboard_init(&server->leaderboard);
+    intern_table_init(&server->players);
+    name_index_init(&server->games);
+    session_table_init(&server->sessions);
+}
+
+/**
+ * Sets up the socket and properties associated with one statfile entry.
+ * @param server - The server instance.
+ * @param stat - The statfile entry.
+ * @param output - Set to the new properties.
+ * @returns NORMAL_EXIT, or the error if the socket could not be opened.
+ */
+enum Error create_game_prop(Server *server, Stat stat, GameProp **output) {
+    GameProp *prop = malloc(sizeof(GameProp));
+    enum Error err = get_socket(&prop->socket, stat.port,
+            server->acceptorAmount > 1, server->backlog);
+    if (err) {
+        free(prop);
+        return err;
+    }
+    struct sockaddr_in in;
+    socklen_t len = sizeof(in);
+    getsockname(prop->socket, (struct sockaddr *) &in, &len);
+    char buffer[6];
+    sprintf(buffer, "%i", ntohs(in.sin_port));
+    prop->port = malloc(sizeof(char) * (strlen(buffer) + 1));
+    strcpy(prop->port, buffer);
+    prop->shardSockets = NULL;
+    prop->listeners = NULL;
+    prop->args = NULL;
+    memset(&prop->accepts, 0, sizeof(AcceptCounters));
+    memset(&prop->plays, 0, sizeof(PlayCounters));
+    prop->latency = NULL;
+    prop->lobbies = 0;
+    prop->waiting = 0;
+    prop->anyPort = strcmp(stat.port, "0") == 0;
+    prop->key = malloc(sizeof(char) * (strlen(server->key) + 1));
+    strcpy(prop->key, server->key);
+    update_game_prop(prop, stat);
+    slab_init(&prop->instances, get_arena_size(prop->playerMax));
+    prop->timeout = server->timeout;
+    prop->reconnectWindow = server->reconnectWindow;
+    prop->leaderboard = &server->leaderboard;
+    *output = prop;
+    return NORMAL_EXIT;
+}
+
+/**
+ * Sets the settings of a game property which come from the statfile. Games
+ * already made copy what they need, so only games made afterwards see the
+ * change.
+ * @param prop - The properties of the game.
+ * @param stat - The statfile entry.
+ */
+void update_game_prop(GameProp *prop, Stat stat) {
+    prop->playerMax = stat.players;
+    prop->startToken = stat.tokens;
+    prop->winPoints = stat.points;
 }
 
 /**
@@ -1001,48 +2743,40 @@ void setup_server(Server *server) {
  * is listening on.
  * @param server - The server instance.
  * @param prop - Properties of the statfile to use.
- * @param key - The auth key.
+ * @param key - The auth key, which the server keeps.
  * @param timeout - Connection timeout rate.
  */
 void setup_game_sockets(Server *server, StatFileProp prop, char *key,
         int timeout) {
-    server->gameProps = malloc(sizeof(GameProp) * prop.amount);
+    server->key = key;
+    server->timeout = timeout;
+    server->gameProps = malloc(sizeof(GameProp *) * prop.amount);
     server->portAmount = prop.amount;
     for (int i = 0; i < prop.amount; i++) {
-        enum Error err = get_socket(&server->gameProps[i].socket,
-                prop.stats[i].port);
+        enum Error err = create_game_prop(server, prop.stats[i],
+                &server->gameProps[i]);
         if (err) {
             exit_with_error(err);
         }
-        struct sockaddr_in in;
-        socklen_t len = sizeof(in);
-        getsockname(server->gameProps[i].socket, (struct sockaddr *) &in,
-                &len);
-        char buffer[6];
-        sprintf(buffer, "%i", ntohs(in.sin_port));
-        server->gameProps[i].port = malloc(sizeof(char) *
-                (strlen(buffer) + 1));
-        strcpy(server->gameProps[i].port, buffer);
-        server->gameProps[i].port[strlen(buffer)] = '\0';
-        server->gameProps[i].key = malloc(sizeof(char) * (strlen(key) + 1));
-        strcpy(server->gameProps[i].key, key);
-        server->gameProps[i].key[strlen(key)] = '\0';
-        server->gameProps[i].instanceSize = 0;
-        server->gameProps[i].instances = malloc(sizeof(struct Game));
-        server->gameProps[i].instanceThreads = malloc(0);
-        server->gameProps[i].playerMax = prop.stats[i].players;
-        server->gameProps[i].startToken = prop.stats[i].tokens;
-        server->gameProps[i].winPoints = prop.stats[i].points;
-        server->gameProps[i].timeout = timeout;
-        server->gameProps[i].currentGameIndex = -1;
-        server->gameProps[i].scoresTable.entryCount = 0;
-        server->gameProps[i].scoresTable.entries = malloc(0);
     }
     for (int i = 0; i < prop.amount; i++) {
         free(prop.stats[i].port);
     }
     free(prop.stats);
-    free(key);
+}
+
+/**
+ * Prints the port of every game property accepting players.
+ * @param server - The server instance.
+ */
+void print_ports(Server *server) {
+    for (int i = 0; i < server->portAmount; i++) {
+        if (i == (server->portAmount - 1)) {
+            fprintf(stderr, "%s\n", server->gameProps[i]->port);
+        } else {
+            fprintf(stderr, "%s ", server->gameProps[i]->port);
+        }
+    }
 }
 
 /**
@@ -1051,26 +2785,15 @@ void setup_game_sockets(Server *server, StatFileProp prop, char *key,
 void signal_handler(int sig) {
     switch(sig) {
         case (SIGINT):
-            printf("SIGINT CAUGHT\n");
-            for (int i = 0; i < sigServer->portAmount; i++) {
-                GameProp prop = sigServer->gameProps[i];
-                if (close(prop.socket) == -1) {
-                    exit_with_error(SYSTEM_ERR);
-                }
-            }
-            free_server(sigServer);
-            // StatFileProp prop = load_statfile(sigServer->statfilePath);
-            // setup_game_sockets(sigServer, prop, sigServer->key,
-            //         sigServer->timeout);
-            // for (int i = 0; i < prop.amount; i++) {
-            //     if (i == (prop.amount - 1)) {
-            //         fprintf(stderr, "%s\n", sigServer->gameProps[i].port);
-            //     } else {
-            //         fprintf(stderr, "%s ", sigServer->gameProps[i].port);
-            //     }
-            // }
-            // start_server(sigServer);
-            exit(0);
+            // Workers close their own journals, so shutting down is left
+            // to the acceptor too.
+            sigServer->stopWanted = 1;
+            reactor_wake(&sigServer->acceptor);
+            break;
+        case (SIGHUP):
+            // Reloading is left to the acceptor, which owns every port.
+            sigServer->reloadWanted = 1;
+            reactor_wake(&sigServer->acceptor);
             break;
         case (SIGTERM):
             // printf("SIGTERM CAUGHT\n");
@@ -1080,7 +2803,8 @@ void signal_handler(int sig) {
 }
 
 /**
- * Sets up signal handler for SIGINT and SIGTERM.
+ * Sets up signal handler for SIGINT and SIGTERM, and ignores SIGPIPE so a
+ * client closing its socket never takes the server down with it.
  */
 void setup_signal_handler() {
     struct sigaction sa;
@@ -1089,6 +2813,20 @@ void setup_signal_handler() {
     sa.sa_flags = 0;
     sigaction(SIGINT, &sa, NULL);
     sigaction(SIGTERM, &sa, NULL);
+    sa.sa_handler = SIG_IGN;
+    sigaction(SIGPIPE, &sa, NULL);
+}
+
+/**
+ * Sets up the signal handler for SIGHUP, which reloads the deckfile and
+ * statfile. Only set up once the acceptor can be woken.
+ */
+void setup_reload_handler() {
+    struct sigaction sa;
+    sa.sa_handler = signal_handler;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = SA_RESTART;
+    sigaction(SIGHUP, &sa, NULL);
 }
 
 /**
@@ -1106,16 +2844,11 @@ int main(int argc, char **argv) {
         exit_with_error(err);
     }
     load_deckfile(&server, argv[DECKFILE]);
+    server.deckfilePath = argv[DECKFILE];
     server.statfilePath = argv[STATFILE];
     StatFileProp prop = load_statfile(argv[STATFILE]);
     setup_game_sockets(&server, prop, key, atoi(argv[TIMEOUT]));
-    for (int i = 0; i < prop.amount; i++) {
-        if (i == (prop.amount - 1)) {
-            fprintf(stderr, "%s\n", server.gameProps[i].port);
-        } else {
-            fprintf(stderr, "%s ", server.gameProps[i].port);
-        }
-    }
+    print_ports(&server);
     start_server(&server);
     free_server(&server);
 }
\ No newline at end of file
@@ -2,10 +2,49 @@
 #define RAFIKI_H
 
 #include "shared.h"
+#include "reactor.h"
+#include "scores.h"
+#include "names.h"
+#include "slab.h"
+#include "decks.h"
+#include "messages.h"
+#include "outbox.h"
+#include "sessions.h"
+#include "journal.h"
+#include "intern.h"
+#include "latency.h"
+#include "statfile.h"
 
-#define EXPECTED_STATFILE_SEP 3
 #define EXPECTED_ARGC 5
 
+// Settings which do not fit the fixed arguments are read from the
+// environment.
+#define HIGH_WATER_ENV "RAFIKI_HIGH_WATER"
+#define BACKEND_ENV "RAFIKI_BACKEND"
+#define ACCEPTORS_ENV "RAFIKI_ACCEPTORS"
+#define BACKLOG_ENV "RAFIKI_BACKLOG"
+#define RECONNECT_ENV "RAFIKI_RECONNECT_WINDOW"
+#define JOURNAL_ENV "RAFIKI_JOURNAL"
+#define JOURNAL_SYNC_ENV "RAFIKI_JOURNAL_SYNC"
+#define RECOVER_ENV "RAFIKI_RECOVER"
+
+// Seconds a player who drops out of a game has to reconnect before the
+// game is ended.
+#define RECONNECT_WINDOW 10
+// Large enough for a reconnect ID of any game name.
+#define RID_BUFFER_SIZE (LINE_READER_SIZE + MESSAGE_BUFFER_SIZE)
+// Bytes set aside in a game's arena for its name. Longer names still fit,
+// the arena just grows to hold them.
+#define ARENA_NAME_SIZE 32
+
+// Files kept in the journal directory. Each worker appends to its own shard
+// of the current epoch, and recovery folds everything in to the checkpoint.
+#define JOURNAL_CHECKPOINT "checkpoint.journal"
+#define JOURNAL_CHECKPOINT_TEMP "checkpoint.journal.tmp"
+#define JOURNAL_SHARD_FORMAT "shard%ld.%d.journal"
+// Large enough for any port a game is journaled with.
+#define JOURNAL_PORT_SIZE 6
+
 /**
  * Enum for rafiki arguments.
  */
@@ -16,63 +55,96 @@ enum Args {
     TIMEOUT = 4
 };
 
-/**
- * Enum for statfile indexes.
- */
-enum StatFile {
-    PORT = 0,
-    START_TOKENS = 1,
-    START_POINTS = 2,
-    START_PLAYERS = 3,
-};
-
 /**
  * Enum for connection types to the server.
  */
 enum ConnectionType {
     PLAYER_CONNECT,
     SCORES_CONNECT,
+    STATS_CONNECT,
+    LATENCY_CONNECT,
     PLAYER_RECONNECT,
     INVALID_CONNECT,
 };
 
 /**
- * Type defination for a score entry.
+ * Enum for the latencies measured on each port. Turn latency is how long
+ * players take to answer dowhat, the rest are time spent by the server
+ * handling a move, taking a connection from being accepted to handing it on
+ * and getting a full game to its first dowhat.
  */
-typedef struct {
-    char *playerName;
-    int tokensTaken;
-    int pointsEarned;
-} ScoreEntry;
+enum Latency {
+    TURN_LATENCY,
+    MOVE_LATENCY,
+    HANDSHAKE_LATENCY,
+    START_LATENCY,
+    LATENCY_KINDS
+};
+
+/**
+ * Enum for the stages of a connection handshake.
+ */
+enum HandshakeState {
+    AWAIT_CONNECT,
+    AWAIT_GAME_NAME,
+    AWAIT_PLAYER_NAME,
+    AWAIT_RID,
+};
+
+struct ServerGameArgs;
 
 /**
- * Type defination for a table of score entries.
+ * Type defination for counts kept about the games played with one game
+ * property. Workers add to them as games are played, and they are only
+ * read to report stats. Disconnects are games ended by a player leaving,
+ * while drops are players who lost their connection mid game, whether or
+ * not they came back in time.
  */
 typedef struct {
-    int entryCount;
-    ScoreEntry *entries;
-} ScoreTable;
+    unsigned long finished;
+    unsigned long moves;
+    unsigned long errors;
+    unsigned long disconnects;
+    unsigned long drops;
+} PlayCounters;
 
 /**
  * Type defination properties of a game also stores instances of games with
- * the properties of the type.
+ * the properties of the type. Properties keep their address for as long as
+ * the server runs, even once a reload stops them accepting players, so the
+ * games played with them are never moved.
  */
 typedef struct {
     int socket;
+    int *shardSockets;
+    Connection **listeners;
+    struct ServerGameArgs *args;
+    AcceptCounters accepts;
+    PlayCounters plays;
+    Histogram *latency;
+    int lobbies;
+    int waiting;
+    int anyPort;
     char *port;
     char *key;
-    pthread_t mainThread;
     int playerMax;
-    int currentGameIndex;
-    int instanceSize;
-    struct Game *instances;
-    pthread_t *instanceThreads;
+    GameSlab instances;
     int startToken;
     int winPoints;
     int timeout;
-    ScoreTable scoresTable;
+    int reconnectWindow;
+    Leaderboard *leaderboard;
 } GameProp;
 
+/**
+ * Type defination for a worker thread which plays many games at once.
+ */
+typedef struct {
+    pthread_t thread;
+    Reactor reactor;
+    Journal *journal;
+} Worker;
+
 /**
  * Type defination for the main server.
  */
@@ -80,49 +152,177 @@ typedef struct {
     int timeout;
     int socket;
     int portAmount;
-    GameProp *gameProps;
+    GameProp **gameProps;
+    int retiredAmount;
+    GameProp **retiredProps;
     char *key;
     char **ports;
-    int deckSize;
-    struct Card *deck;
+    SharedDeck *deck;
+    char *deckfilePath;
     char *statfilePath;
+    volatile sig_atomic_t reloadWanted;
+    volatile sig_atomic_t stopWanted;
+    Leaderboard leaderboard;
+    InternTable players;
+    NameIndex games;
+    SessionTable sessions;
+    Reactor acceptor;
+    pthread_mutex_t lock;
+    int highWater;
+    enum ReactorBackend backend;
+    int acceptorAmount;
+    int backlog;
+    int reconnectWindow;
+    char *journalPath;
+    int journalSync;
+    long journalEpoch;
+    long journalSerial;
+    int workerAmount;
+    int nextWorker;
+    long startTime;
+    long statsTime;
+    unsigned long statsMoves;
+    Worker *workers;
 } Server;
 
 /**
- * Type defination one entry of a statfile.
+ * Type defination for the server and game property a listening socket
+ * accepts connections for.
+ */
+typedef struct ServerGameArgs {
+    Server *server;
+    GameProp *prop;
+} ServerGameArgs;
+
+/**
+ * Type defination for starting or stopping one of a game property's
+ * accepting sockets on the worker which owns it.
  */
 typedef struct {
-    char *port;
-    int tokens;
-    int points;
-    int players;
-} Stat;
+    GameProp *prop;
+    int shard;
+} ShardListen;
 
 /**
- * Type defination for properties of a statfile.
+ * Type defination for the progress of a connection which has not yet
+ * completed its handshake.
  */
 typedef struct {
-    int amount;
-    Stat *stats;
-} StatFileProp;
+    ServerGameArgs *args;
+    enum HandshakeState state;
+    char *gameName;
+    uint64_t accepted;
+    Timer timer;
+} Handshake;
 
 /**
- * Type defination arguments to the pthread when creating a
- * new game property on the server.
+ * Type defination for a player who has completed their handshake on one of
+ * the workers and is waiting to be matched in to a game by the acceptor.
+ */
+typedef struct {
+    ServerGameArgs *args;
+    int sock;
+    char *gameName;
+    InternedName *player;
+} Join;
+
+/**
+ * Type defination for a game instance which is waiting for players. Stored
+ * in the data of the instance and in the entry of its name until it is full
+ * or its deadline passes.
+ */
+typedef struct {
+    GameProp *prop;
+    int index;
+    unsigned int generation;
+    NameEntry *entry;
+    Timer timer;
+} Lobby;
+
+/**
+ * Type defination arguments to the pthread when sending scores to
+ * a connection.
  */
 typedef struct {
     Server *server;
+    int sock;
+} ScoresArgs;
+
+/**
+ * Type defination for a connection asking for stats or latencies, which the
+ * acceptor reports on before a thread writes the report.
+ */
+typedef struct {
+    Server *server;
+    enum ConnectionType type;
+    int sock;
+    int length;
+    char *text;
+} StatsArgs;
+
+/**
+ * Type defination for the progress of a game instance being played by
+ * a worker. Instances never move, so the worker plays the game in place.
+ */
+typedef struct {
     GameProp *prop;
-} ServerGameArgs;
+    int slot;
+    struct Game *game;
+    Arena *arena;
+    int gameCounter;
+    SessionTable *sessions;
+    SharedDeck *deck;
+    int deckCursor;
+    int currentPlayer;
+    int attempts;
+    Connection **connections;
+    Timer turnTimer;
+    Timer *dropTimers;
+    Outbox outbox;
+    Journal *journal;
+    long serial;
+    Histogram *latency;
+    uint64_t startTime;
+    uint64_t turnStart;
+} GameRun;
+
+/**
+ * Type defination for a player reconnecting to a game, handed to the
+ * worker playing the game.
+ */
+typedef struct {
+    SessionTable *sessions;
+    char *rid;
+    int sock;
+} Rejoin;
 
 /**
- * Type defination arguments to the pthread when creating a
- * new game instance.
+ * Type defination for a game read back from the journal, which is replayed
+ * once its end is read or, if it never ended, resumed once every journal
+ * has been read.
  */
 typedef struct {
     GameProp *prop;
-    int currentGameIndex;
-} GameInstanceArgs;
+    int gameCounter;
+    int playerCount;
+    char *name;
+    char **playerNames;
+    int moveCount;
+    int moveCapacity;
+    int *movePlayers;
+    char **moves;
+} JournaledGame;
+
+/**
+ * Type defination for the progress of recovering from the journal. Games
+ * are indexed by the serial they were journaled under in this epoch.
+ */
+typedef struct {
+    Server *server;
+    long epoch;
+    long gameCapacity;
+    JournaledGame **games;
+} Recovery;
 
 #include "rafiki.h"
 
@@ -133,56 +333,151 @@ Server *sigServer;
 /**
  * Function prototypes.
  */
+void free_game_prop(GameProp *prop);
 void free_server(Server *server);
+void report_error(int error);
 void exit_with_error(int error);
 void check_args(int argc, char **argv);
 void load_deckfile(Server *server, char *path);
-int check_stat_line(char *line);
-Stat generate_stat(char *line);
-int index_of_non_zero_port(StatFileProp prop, char *port);
 StatFileProp load_statfile(char *path);
-enum Error get_socket(int *output, char *port);
+enum Error get_socket(int *output, char *port, int shared, int backlog);
 void add_score_entry(GameProp *prop, ScoreEntry entry);
-enum ErrorCode update_scores(GameProp *prop, struct Game *game,
-enum MessageFromPlayer type, char *message, int playerId);
-enum ErrorCode do_what(GameProp *prop, struct Game *game, int playerId);
-void send_all(struct Game *game, char *message, ...);
-void *game_instance_thread(void *arg);
+void update_scores(GameProp *prop, struct Game *game, int playerId,
+        int tokensTaken, int pointsEarned);
+enum ErrorCode play_purchase(GameRun *run, int playerId, char *line);
+enum ErrorCode play_take(GameRun *run, int playerId, char *line);
+void play_wild(GameRun *run, int playerId);
+enum ErrorCode do_what(GameRun *run, int playerId, char *line);
+void send_do_what(GameRun *run, int playerId);
+int get_timeout_milliseconds(GameProp *prop);
+int flush_game(Reactor *reactor, GameRun *run);
+void send_all(struct Game *game, char *message, int length);
+int index_of_connection(GameRun *run, Connection *connection);
+void end_game(Reactor *reactor, GameRun *run, enum MessageFromHub type,
+        int playerId);
+void refill_board(GameRun *run);
+void turn_expired(void *context, Timer *timer);
+void drop_expired(void *context, Timer *timer);
+void drop_player(Reactor *reactor, GameRun *run, int playerId);
+char *get_session_key(char *buffer, GameRun *run, int playerId);
+void add_sessions(GameRun *run, Reactor *reactor);
+void remove_sessions(GameRun *run);
+void send_snapshot(GameRun *run, int playerId);
+int can_rejoin(GameRun *run, int playerId);
+void rejoin_game(Reactor *reactor, void *arg);
+void journal_game(GameRun *run);
+void journal_move(GameRun *run, int playerId, char *line);
+void journal_end(GameRun *run);
+void commit_journal(Reactor *reactor, void *arg);
+void await_move(Reactor *reactor, GameRun *run);
+int next_turn(Reactor *reactor, GameRun *run);
+void advance_game(Reactor *reactor, GameRun *run);
+void handle_game_input(Reactor *reactor, Connection *connection);
+void setup_game_timers(GameRun *run);
+void start_game(Reactor *reactor, void *arg);
+void stop_worker(Reactor *reactor, void *arg);
+void *worker_thread(void *arg);
+void setup_workers(Server *server);
+void start_workers(Server *server);
 void setup_player_fd(struct GamePlayer *player, int sock);
 void add_player(struct Game *game, struct GamePlayer *player,
-        pthread_mutex_t *lock);
-struct Game setup_instance(char *name, int token, int winScore);
-void add_instance(GameProp *prop, struct Game game, pthread_mutex_t *lock);
-int index_of_instance(GameProp *prop, char *name);
-int setup_player(struct GamePlayer *player, int id);
+        Arena *arena, pthread_mutex_t *lock);
+struct Game setup_instance(Arena *arena, char *name, int token,
+        int winScore);
+size_t get_arena_size(int playerMax);
+int add_instance(GameProp *prop);
+void free_instance(struct Game *instance);
+void reap_instance(GameProp *prop, int index);
+void setup_player(struct GamePlayer *player, int id, InternedName *name);
 int get_game_amount(Server *server, char *name);
 int compare_name(const void *a, const void *b);
 void assign_id(struct Game *game);
-void send_game_initial_messages(Server *server, GameProp *prop,
-        struct Game game);
+void send_game_initial_messages(Server *server, GameRun *run);
 void setup_scores_table(GameProp *prop, struct Game *instance);
+void lobby_expired(void *context, Timer *timer);
+void wait_for_players(Server *server, GameProp *prop, int index);
+void close_lobby(Server *server, struct Game *instance);
+Worker *next_worker(Server *server, pthread_mutex_t *lock);
 void play_game(Server *server, GameProp *prop, int index,
         pthread_mutex_t *lock);
-void create_new_game(GameProp *prop, struct GamePlayer *player,
-        char *name, pthread_mutex_t *lock);
+int create_new_game(GameProp *prop, struct GamePlayer *player,
+        char *name, InternedName *playerName, pthread_mutex_t *lock);
 void add_to_existing_game(GameProp *prop, struct GamePlayer *player,
-        int index, pthread_mutex_t *lock);
-int get_avaliable_game(GameProp *prop, char *name);
-int get_avaliable_game_all(Server *server, char *name, char **portOut);
+        InternedName *playerName, int index, pthread_mutex_t *lock);
+int get_avaliable_game_all(Server *server, char *name, GameProp **propOut);
 GameProp *get_prop_by_port(Server *server, char *port);
-int index_of_player_in_table(ScoreTable table, char *playerName);
-void combine_all_scores_and_send(Server *server, FILE *toConnection);
-enum ConnectionType verify_connection(GameProp *prop, FILE *toConnection,
-        FILE *fromConnection);
-void handle_player_connect(Server *server, GameProp *prop, FILE *toConnection,
-        FILE *fromConnection, int sock, pthread_mutex_t gamePropLock);
-void handle_connection(Server *server, GameProp *prop, int sock);
-void *listen_thread(void *argv);
+void send_scores(Server *server, int sock);
+void *scores_thread(void *arg);
+long get_milliseconds(void);
+void write_prop_stats(FILE *output, GameProp *prop, int listening);
+char *format_stats(Server *server, int *length);
+void write_prop_latency(FILE *output, Server *server, GameProp *prop);
+char *format_latency(Server *server, int *length);
+void *stats_thread(void *arg);
+void report_stats(Reactor *reactor, void *arg);
+void queue_stats(Reactor *reactor, Server *server, int sock,
+        enum ConnectionType type);
+void setup_latency(Server *server, GameProp *prop);
+Histogram *get_latency(Server *server, GameProp *prop, Reactor *reactor);
+void send_reply(int sock, char *message);
+enum ConnectionType verify_connection(GameProp *prop, int sock, char *line);
+void handle_player_reconnect(Server *server, GameProp *prop, int sock,
+        char *rid);
+void handle_player_connect(Server *server, GameProp *prop,
+        struct GamePlayer *player, char *gameName,
+        InternedName *playerName);
+void join_game(Reactor *reactor, void *arg);
+void queue_join(Reactor *reactor, ServerGameArgs *args, int sock,
+        char *gameName, InternedName *playerName);
+void record_handshake(Reactor *reactor, Handshake *handshake);
+void end_handshake(Reactor *reactor, Connection *connection,
+        int closeSocket);
+void handshake_expired(void *context, Timer *timer);
+int advance_handshake(Reactor *reactor, Connection *connection, char *line);
+void handle_handshake_input(Reactor *reactor, Connection *connection);
+void accept_connection(Reactor *reactor, Connection *listener, int sock);
+void start_shard(Reactor *reactor, void *arg);
+void stop_shard(Reactor *reactor, void *arg);
+void post_shard(Server *server, GameProp *prop, int shard, Task task);
+int listen_on_shards(Server *server, GameProp *prop);
+int listen_on_prop(Server *server, GameProp *prop);
+void stop_listening(Server *server, GameProp *prop);
+char *get_journal_path(Server *server, char *name);
+int get_shard_epoch(char *name, long *epoch);
+JournaledGame *find_journaled_game(Recovery *recovery, long serial);
+void add_journaled_game(Recovery *recovery, long serial,
+        JournaledGame *journaled);
+void free_journaled_game(JournaledGame *journaled);
+char *copy_record_text(char *record, int offset);
+GameProp *get_journaled_prop(Server *server, char *port, int playerCount);
+void recover_start(Recovery *recovery, char *record);
+void recover_player_or_move(Recovery *recovery, char *record);
+void recover_end(Recovery *recovery, char *record);
+void read_journal_record(void *arg, char *record);
+GameRun *replay_game(Server *server, JournaledGame *journaled,
+        Journal *journal);
+void discard_replay(GameRun *run);
+void resume_game(Reactor *reactor, void *arg);
+void remove_shard_journals(Server *server, long keepEpoch);
+void read_shard_journals(Recovery *recovery);
+void journal_scores(Journal *journal, Leaderboard *board);
+void open_journals(Server *server);
+void recover_journal(Server *server);
+void setup_journal(Server *server);
+int find_reloaded_prop(Server *server, Stat stat, int *kept);
+void reload_server(Server *server);
+void check_signals(Reactor *reactor, void *arg);
 void start_server(Server *server);
+void stop_server(Server *server);
+enum ReactorBackend get_backend_setting(void);
 void setup_server(Server *server);
+enum Error create_game_prop(Server *server, Stat stat, GameProp **output);
+void update_game_prop(GameProp *prop, Stat stat);
 void setup_game_sockets(Server *server, StatFileProp prop, char *key,
         int timeout);
+void print_ports(Server *server);
 void signal_handler(int sig);
 void setup_signal_handler();
+void setup_reload_handler();
 
 #endif
\ No newline at end of file
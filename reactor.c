@@ -0,0 +1,961 @@
+#define _GNU_SOURCE
+#include <sys/eventfd.h>
+#include <poll.h>
+#include <stdint.h>
+#include <netinet/tcp.h>
+#include "reactor.h"
+
+// The low bits of the user data of an io_uring operation say what the
+// operation was for, and the rest points to its connection.
+#define OPERATION_RECEIVE 0
+#define OPERATION_SEND 1
+#define OPERATION_ACCEPT 2
+#define OPERATION_IGNORED 3
+#define OPERATION_MASK 3
+
+static void arm_wake(Reactor *reactor);
+static ssize_t send_without_blocking(int fd, struct iovec *segments,
+        int count);
+
+/**
+ * Sets up an event loop. If io_uring is asked for but is not available the
+ * reactor uses epoll instead.
+ * @param reactor - The reactor to setup.
+ * @param backend - How the reactor should wait for sockets.
+ * @return 0 on success, -1 if the reactor could not be created.
+ */
+int reactor_init(Reactor *reactor, enum ReactorBackend backend) {
+    reactor->backend = backend;
+    reactor->epoll = -1;
+    reactor->attention = NULL;
+    if (backend == REACTOR_URING &&
+            uring_init(&reactor->ring, REACTOR_URING_ENTRIES) == -1) {
+        reactor->backend = REACTOR_EPOLL;
+    }
+    if (reactor->backend == REACTOR_EPOLL) {
+        reactor->epoll = epoll_create1(EPOLL_CLOEXEC);
+    }
+    reactor->running = 0;
+    reactor->highWater = REACTOR_HIGH_WATER;
+    reactor->released = NULL;
+    timer_wheel_init(&reactor->timers);
+    reactor->posted = NULL;
+    reactor->postedTail = NULL;
+    reactor->postedCount = 0;
+    reactor->connectionCount = 0;
+    reactor->idle = NULL;
+    reactor->idleArg = NULL;
+    pthread_mutex_init(&reactor->postedLock, NULL);
+    reactor->wake = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (reactor->wake == -1) {
+        return -1;
+    }
+    if (reactor->backend == REACTOR_URING) {
+        arm_wake(reactor);
+        return 0;
+    }
+    if (reactor->epoll == -1) {
+        return -1;
+    }
+    // The wake eventfd is the only registration without a connection.
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.ptr = NULL;
+    return epoll_ctl(reactor->epoll, EPOLL_CTL_ADD, reactor->wake, &event);
+}
+
+/**
+ * Switches a socket between blocking and non-blocking mode.
+ * @param sock - The socket to modify.
+ * @param nonBlocking - 1 to make the socket non-blocking, 0 to block.
+ * @return 0 on success, -1 on failure.
+ */
+int set_non_blocking(int sock, int nonBlocking) {
+    int flags = fcntl(sock, F_GETFL, 0);
+    if (flags == -1) {
+        return -1;
+    }
+    flags = nonBlocking ? (flags | O_NONBLOCK) : (flags & ~O_NONBLOCK);
+    return fcntl(sock, F_SETFL, flags);
+}
+
+/**
+ * Prepares an io_uring operation, which is submitted the next time the
+ * reactor waits.
+ * @param reactor - The reactor to submit on.
+ * @param opcode - The io_uring operation.
+ * @param fd - The file descriptor to operate on.
+ * @param buffer - The buffer to operate with, if any.
+ * @param length - The length of the buffer.
+ * @param connection - The connection the operation is for, NULL if none.
+ * @param operation - What the operation is for.
+ * @return the prepared entry, for any other fields to be set.
+ */
+static struct io_uring_sqe *prepare(Reactor *reactor, int opcode, int fd,
+        void *buffer, unsigned int length, Connection *connection,
+        int operation) {
+    struct io_uring_sqe *sqe = uring_get_sqe(&reactor->ring);
+    sqe->opcode = opcode;
+    sqe->fd = fd;
+    sqe->addr = (uintptr_t) buffer;
+    sqe->len = length;
+    sqe->user_data = (uintptr_t) connection | operation;
+    if (connection != NULL && operation != OPERATION_IGNORED) {
+        connection->operations++;
+    }
+    return sqe;
+}
+
+/**
+ * Waits for the wake eventfd to be written to.
+ * @param reactor - The reactor to wake.
+ */
+static void arm_wake(Reactor *reactor) {
+    struct io_uring_sqe *sqe = prepare(reactor, IORING_OP_POLL_ADD,
+            reactor->wake, NULL, 0, NULL, OPERATION_RECEIVE);
+    sqe->poll32_events = POLLIN;
+}
+
+/**
+ * Receives in to the free space of a connection's buffer. The receive is
+ * left for later if the buffer is full.
+ * @param reactor - The reactor the connection is registered with.
+ * @param connection - The connection.
+ */
+static void arm_receive(Reactor *reactor, Connection *connection) {
+    LineReader *reader = &connection->reader;
+    int space = line_reader_compact(reader);
+    if (space == 0) {
+        return;
+    }
+    prepare(reactor, IORING_OP_RECV, connection->fd,
+            reader->buffer + reader->length, space, connection,
+            OPERATION_RECEIVE);
+    connection->receiving = 1;
+}
+
+/**
+ * Sends the rest of a connection's flight buffer.
+ * @param reactor - The reactor the connection is registered with.
+ * @param connection - The connection.
+ */
+static void arm_send(Reactor *reactor, Connection *connection) {
+    struct io_uring_sqe *sqe = prepare(reactor, IORING_OP_SEND,
+            connection->fd, connection->flight + connection->flightStart,
+            connection->flightLength, connection, OPERATION_SEND);
+    sqe->msg_flags = MSG_NOSIGNAL;
+}
+
+/**
+ * Moves a connection's queued output in to its flight buffer and sends it,
+ * unless a send is already in flight.
+ * @param reactor - The reactor the connection is registered with.
+ * @param connection - The connection.
+ */
+static void send_pending(Reactor *reactor, Connection *connection) {
+    if (connection->flightLength > 0 || connection->pendingLength == 0) {
+        return;
+    }
+    // Swap the buffers rather than copying, the old flight buffer is empty.
+    char *empty = connection->flight;
+    int emptyCapacity = connection->flightCapacity;
+    connection->flight = connection->pending;
+    connection->flightCapacity = connection->pendingCapacity;
+    connection->flightStart = connection->pendingStart;
+    connection->flightLength = connection->pendingLength;
+    connection->pending = empty;
+    connection->pendingCapacity = emptyCapacity;
+    connection->pendingStart = 0;
+    connection->pendingLength = 0;
+    arm_send(reactor, connection);
+}
+
+/**
+ * Lists a connection to have its receive and send submitted before the
+ * reactor next waits.
+ * @param reactor - The reactor the connection is registered with.
+ * @param connection - The connection.
+ */
+static void need_attention(Reactor *reactor, Connection *connection) {
+    if (connection->attention) {
+        return;
+    }
+    connection->attention = 1;
+    connection->nextAttention = reactor->attention;
+    reactor->attention = connection;
+}
+
+/**
+ * Submits a receive and send for every connection listed for attention.
+ * Connections with a full buffer stay listed until it has room again.
+ * @param reactor - The reactor to tend to.
+ */
+static void tend_attention(Reactor *reactor) {
+    Connection *connection = reactor->attention;
+    reactor->attention = NULL;
+    while (connection != NULL) {
+        Connection *next = connection->nextAttention;
+        connection->attention = 0;
+        if (!connection->released) {
+            if (!connection->receiving && !connection->closed &&
+                    !connection->paused) {
+                arm_receive(reactor, connection);
+                if (!connection->receiving) {
+                    need_attention(reactor, connection);
+                }
+            }
+            send_pending(reactor, connection);
+        }
+        connection = next;
+    }
+}
+
+/**
+ * Allocates a connection and registers it for input events. Reads are always
+ * made without blocking, so the socket's own mode is left for writers.
+ * @param reactor - The reactor to register with.
+ * @param sock - The socket of the connection.
+ * @param data - Arbitrary data given back to the handlers.
+ * @return the connection, NULL if the socket could not be registered.
+ */
+static Connection *register_connection(Reactor *reactor, int sock,
+        void *data) {
+    Connection *connection = malloc(sizeof(Connection));
+    connection->fd = sock;
+    connection->closed = 0;
+    connection->released = 0;
+    connection->nextReleased = NULL;
+    connection->onAccept = NULL;
+    connection->accepts = NULL;
+    connection->onInput = NULL;
+    connection->data = data;
+    connection->overflowed = 0;
+    connection->paused = 0;
+    connection->pending = NULL;
+    connection->pendingStart = 0;
+    connection->pendingLength = 0;
+    connection->pendingCapacity = 0;
+    connection->operations = 0;
+    connection->receiving = 0;
+    connection->attention = 0;
+    connection->nextAttention = NULL;
+    connection->flight = NULL;
+    connection->flightStart = 0;
+    connection->flightLength = 0;
+    connection->flightCapacity = 0;
+    line_reader_init(&connection->reader, sock);
+    if (reactor->backend == REACTOR_URING) {
+        return connection;
+    }
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.ptr = connection;
+    if (epoll_ctl(reactor->epoll, EPOLL_CTL_ADD, sock, &event) == -1) {
+        free(connection);
+        return NULL;
+    }
+    return connection;
+}
+
+/**
+ * Submits an accept on a listening socket.
+ * @param reactor - The reactor the listener is registered with.
+ * @param listener - The listening connection.
+ */
+static void arm_accept(Reactor *reactor, Connection *listener) {
+    struct io_uring_sqe *sqe = prepare(reactor, IORING_OP_ACCEPT,
+            listener->fd, NULL, 0, listener, OPERATION_ACCEPT);
+    sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+}
+
+/**
+ * Registers a listening socket with the reactor. Accepted sockets are
+ * non-blocking and closed on exec.
+ * @param reactor - The reactor to register with.
+ * @param sock - The listening socket.
+ * @param handler - Called with each accepted socket.
+ * @param counters - Where accepts are counted, may be NULL.
+ * @param data - Arbitrary data given back to the handler.
+ * @return the connection representing the listener, NULL on failure.
+ */
+Connection *reactor_listen(Reactor *reactor, int sock, AcceptHandler handler,
+        AcceptCounters *counters, void *data) {
+    if (set_non_blocking(sock, 1) == -1) {
+        return NULL;
+    }
+    Connection *listener = register_connection(reactor, sock, data);
+    if (listener != NULL) {
+        listener->onAccept = handler;
+        listener->accepts = counters;
+        if (reactor->backend == REACTOR_URING) {
+            arm_accept(reactor, listener);
+        }
+    }
+    return listener;
+}
+
+/**
+ * Registers a connected socket with the reactor.
+ * @param reactor - The reactor to register with.
+ * @param sock - The connected socket.
+ * @param handler - Called whenever new input arrives or the peer closes.
+ * @param data - Arbitrary data given back to the handler.
+ * @return the connection, NULL on failure.
+ */
+Connection *reactor_watch(Reactor *reactor, int sock, InputHandler handler,
+        void *data) {
+    Connection *connection = register_connection(reactor, sock, data);
+    if (connection != NULL) {
+        connection->onInput = handler;
+        __atomic_fetch_add(&reactor->connectionCount, 1, __ATOMIC_RELAXED);
+        if (reactor->backend == REACTOR_URING) {
+            arm_receive(reactor, connection);
+        }
+    }
+    return connection;
+}
+
+/**
+ * Stops watching a connection. The connection is freed once the current
+ * batch of events has been handled, so it is safe to release any connection
+ * from within a handler, but it must not be used again by the caller. Any
+ * output still queued is sent one last time without blocking, unless an
+ * earlier send is still in flight with io_uring, and whatever the socket's
+ * own buffer cannot take is dropped, as the peer has stopped reading.
+ * @param reactor - The reactor the connection is registered with.
+ * @param connection - The connection to release.
+ * @param closeSocket - 1 if the socket should also be closed.
+ */
+void reactor_release(Reactor *reactor, Connection *connection,
+        int closeSocket) {
+    if (connection->onAccept == NULL) {
+        __atomic_fetch_sub(&reactor->connectionCount, 1, __ATOMIC_RELAXED);
+    }
+    if (reactor->backend == REACTOR_EPOLL) {
+        // Output queued since the socket last filled up, such as a final
+        // message, is handed over while the socket is still open.
+        if (connection->pendingLength > 0) {
+            struct iovec segment;
+            segment.iov_base = connection->pending + connection->pendingStart;
+            segment.iov_len = connection->pendingLength;
+            send_without_blocking(connection->fd, &segment, 1);
+        }
+        epoll_ctl(reactor->epoll, EPOLL_CTL_DEL, connection->fd, NULL);
+    } else {
+        // The connection is only freed once everything in flight for it
+        // has completed, which cancelling hurries along. A listener always
+        // has an accept in flight, which holds its socket open.
+        if (connection->onAccept != NULL) {
+            prepare(reactor, IORING_OP_ASYNC_CANCEL, -1,
+                    (void *) ((uintptr_t) connection | OPERATION_ACCEPT), 0,
+                    NULL, OPERATION_IGNORED);
+        }
+        if (connection->receiving) {
+            prepare(reactor, IORING_OP_ASYNC_CANCEL, -1,
+                    (void *) ((uintptr_t) connection | OPERATION_RECEIVE), 0,
+                    NULL, OPERATION_IGNORED);
+        }
+        if (connection->flightLength > 0) {
+            prepare(reactor, IORING_OP_ASYNC_CANCEL, -1,
+                    (void *) ((uintptr_t) connection | OPERATION_SEND), 0,
+                    NULL, OPERATION_IGNORED);
+        }
+        // Output queued since the reactor last waited, such as a final
+        // message, is handed over now without waiting for room, while the
+        // socket is still open. Not if a send is still in flight though, as
+        // how much of it the cancel leaves unsent is not known yet, so the
+        // queued output could only follow it out of order.
+        if (connection->pendingLength > 0 && connection->flightLength == 0) {
+            struct io_uring_sqe *sqe = prepare(reactor, IORING_OP_SEND,
+                    connection->fd,
+                    connection->pending + connection->pendingStart,
+                    connection->pendingLength, connection, OPERATION_SEND);
+            sqe->msg_flags = MSG_NOSIGNAL | MSG_DONTWAIT;
+        }
+        uring_flush(&reactor->ring);
+    }
+    if (closeSocket) {
+        close(connection->fd);
+    }
+    connection->released = 1;
+    connection->nextReleased = reactor->released;
+    reactor->released = connection;
+}
+
+/**
+ * Frees all connections released while handling the last batch of events,
+ * other than those which still have io_uring operations in flight or are
+ * still listed for attention.
+ * @param reactor - The reactor to clean up.
+ * @param everything - 1 to free connections even if they are in use.
+ */
+static void free_released(Reactor *reactor, int everything) {
+    Connection **link = &reactor->released;
+    while (*link != NULL) {
+        Connection *connection = *link;
+        if ((connection->operations > 0 || connection->attention) &&
+                !everything) {
+            link = &connection->nextReleased;
+            continue;
+        }
+        *link = connection->nextReleased;
+        free(connection->pending);
+        free(connection->flight);
+        free(connection);
+    }
+}
+
+/**
+ * Frees resources held by an event loop. Connections still registered are
+ * not freed.
+ * @param reactor - The reactor to free.
+ */
+void reactor_free(Reactor *reactor) {
+    if (reactor->backend == REACTOR_URING) {
+        uring_free(&reactor->ring);
+    } else {
+        close(reactor->epoll);
+    }
+    free_released(reactor, 1);
+    while (reactor->posted != NULL) {
+        PostedTask *next = reactor->posted->next;
+        free(reactor->posted);
+        reactor->posted = next;
+    }
+    pthread_mutex_destroy(&reactor->postedLock);
+    close(reactor->wake);
+}
+
+/**
+ * Queues work to be run on the reactor's own thread. Safe to call from any
+ * thread.
+ * @param reactor - The reactor to run the task.
+ * @param task - The task to run.
+ * @param arg - The argument to give to the task.
+ */
+void reactor_post(Reactor *reactor, Task task, void *arg) {
+    PostedTask *posted = malloc(sizeof(PostedTask));
+    posted->task = task;
+    posted->arg = arg;
+    posted->next = NULL;
+    pthread_mutex_lock(&reactor->postedLock);
+    if (reactor->postedTail == NULL) {
+        reactor->posted = posted;
+    } else {
+        reactor->postedTail->next = posted;
+    }
+    reactor->postedTail = posted;
+    reactor->postedCount++;
+    pthread_mutex_unlock(&reactor->postedLock);
+    eventfd_write(reactor->wake, 1);
+}
+
+/**
+ * Wakes a reactor without giving it any work, so its idle task runs. Only
+ * writes to the eventfd, so it is safe to call from a signal handler.
+ * @param reactor - The reactor to wake.
+ */
+void reactor_wake(Reactor *reactor) {
+    eventfd_write(reactor->wake, 1);
+}
+
+/**
+ * Gets the amount of tasks posted to a reactor which it has not yet woken
+ * to run. Safe to call from any thread.
+ * @param reactor - The reactor.
+ * @return the amount of tasks.
+ */
+int reactor_queue_depth(Reactor *reactor) {
+    pthread_mutex_lock(&reactor->postedLock);
+    int depth = reactor->postedCount;
+    pthread_mutex_unlock(&reactor->postedLock);
+    return depth;
+}
+
+/**
+ * Gets the amount of connections a reactor is watching, not counting
+ * listening sockets. Safe to call from any thread.
+ * @param reactor - The reactor.
+ * @return the amount of connections.
+ */
+int reactor_connection_count(Reactor *reactor) {
+    return __atomic_load_n(&reactor->connectionCount, __ATOMIC_RELAXED);
+}
+
+/**
+ * Arms a timer on the reactor. Must be called from the reactor's thread.
+ * The timer's handler is given the reactor as its context.
+ * @param reactor - The reactor to arm the timer on.
+ * @param timer - The timer to arm.
+ * @param milliseconds - How long until the timer expires.
+ */
+void reactor_arm(Reactor *reactor, Timer *timer, int milliseconds) {
+    timer_wheel_add(&reactor->timers, timer, milliseconds);
+}
+
+/**
+ * Disarms a timer on the reactor. Must be called from the reactor's thread.
+ * @param reactor - The reactor the timer is armed on.
+ * @param timer - The timer to disarm.
+ */
+void reactor_disarm(Reactor *reactor, Timer *timer) {
+    timer_wheel_cancel(&reactor->timers, timer);
+}
+
+/**
+ * Runs all tasks posted to the reactor since it last woke.
+ * @param reactor - The reactor to run tasks on.
+ */
+static void run_posted(Reactor *reactor) {
+    eventfd_t count;
+    eventfd_read(reactor->wake, &count);
+    pthread_mutex_lock(&reactor->postedLock);
+    PostedTask *posted = reactor->posted;
+    reactor->posted = NULL;
+    reactor->postedTail = NULL;
+    reactor->postedCount = 0;
+    pthread_mutex_unlock(&reactor->postedLock);
+    while (posted != NULL) {
+        PostedTask *next = posted->next;
+        posted->task(reactor, posted->arg);
+        free(posted);
+        posted = next;
+    }
+}
+
+/**
+ * Takes the next complete line out of a connection's input buffer. The
+ * newline is replaced by a null terminator, and the line stays valid until
+ * the next time the connection reads from its socket.
+ * @param connection - The connection to read from.
+ * @param line - Set to the start of the line.
+ * @return the length of the line, -1 if no complete line is buffered.
+ */
+int connection_read_line(Connection *connection, char **line) {
+    return line_reader_next(&connection->reader, line);
+}
+
+/**
+ * Checks if a connection's buffer is full without holding a complete line.
+ * @param connection - The connection to check.
+ * @return 1 if no more input can be buffered.
+ */
+int connection_is_full(Connection *connection) {
+    return line_reader_is_full(&connection->reader);
+}
+
+/**
+ * Checks if a connection's buffer has room to receive more input.
+ * @param connection - The connection to check.
+ * @return 1 if more input can be buffered.
+ */
+int connection_has_room(Connection *connection) {
+    return connection->reader.length < LINE_READER_SIZE;
+}
+
+/**
+ * Changes the events a connection is watched for, depending on whether it
+ * is reading and has output waiting.
+ * @param reactor - The reactor the connection is registered with.
+ * @param connection - The connection.
+ */
+static void watch_output(Reactor *reactor, Connection *connection) {
+    struct epoll_event event;
+    event.events = (connection->paused ? 0 : EPOLLIN) |
+            (connection->pendingLength > 0 ? EPOLLOUT : 0);
+    event.data.ptr = connection;
+    epoll_ctl(reactor->epoll, EPOLL_CTL_MOD, connection->fd, &event);
+}
+
+/**
+ * Stops or restarts reading from a connection. Lines already buffered can
+ * still be read while it is paused, and output is still sent. A paused
+ * connection whose peer hangs up is still seen as closed with epoll, but
+ * with io_uring not until reading restarts.
+ * @param reactor - The reactor the connection is registered with.
+ * @param connection - The connection.
+ * @param paused - 1 to stop reading, 0 to restart it.
+ */
+void connection_pause(Reactor *reactor, Connection *connection, int paused) {
+    if (connection->paused == paused) {
+        return;
+    }
+    connection->paused = paused;
+    if (reactor->backend == REACTOR_URING) {
+        if (!paused) {
+            need_attention(reactor, connection);
+        }
+        return;
+    }
+    watch_output(reactor, connection);
+}
+
+/**
+ * Adds bytes to the end of a connection's output queue.
+ * @param connection - The connection.
+ * @param bytes - The bytes to queue.
+ * @param length - The amount of bytes.
+ */
+static void queue_output(Connection *connection, char *bytes, int length) {
+    int end = connection->pendingStart + connection->pendingLength;
+    if (end + length > connection->pendingCapacity) {
+        memmove(connection->pending,
+                connection->pending + connection->pendingStart,
+                connection->pendingLength);
+        connection->pendingStart = 0;
+        end = connection->pendingLength;
+    }
+    if (end + length > connection->pendingCapacity) {
+        connection->pendingCapacity = max(end + length,
+                2 * connection->pendingCapacity);
+        connection->pending = realloc(connection->pending,
+                connection->pendingCapacity);
+    }
+    memcpy(connection->pending + end, bytes, length);
+    connection->pendingLength += length;
+}
+
+/**
+ * Writes as much as the socket will take without blocking.
+ * @param fd - The socket to write to.
+ * @param segments - The bytes to write.
+ * @param count - The amount of segments.
+ * @return the amount of bytes written, -1 if the socket failed.
+ */
+static ssize_t send_without_blocking(int fd, struct iovec *segments,
+        int count) {
+    struct msghdr message;
+    memset(&message, 0, sizeof(message));
+    message.msg_iov = segments;
+    message.msg_iovlen = count;
+    while (1) {
+        ssize_t sent = sendmsg(fd, &message, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (sent != -1) {
+            return sent;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return 0;
+        }
+        if (errno != EINTR) {
+            return -1;
+        }
+    }
+}
+
+/**
+ * Writes to a connection without ever blocking the reactor. Whatever the
+ * socket cannot take now is queued and written as the peer reads. Once
+ * more than the reactor's high water mark is queued the connection is
+ * marked as overflowed and nothing more is written to it.
+ * @param reactor - The reactor the connection is registered with.
+ * @param connection - The connection to write to.
+ * @param segments - The bytes to write.
+ * @param count - The amount of segments.
+ * @return 0 on success, -1 if the connection has overflowed.
+ */
+int connection_write(Reactor *reactor, Connection *connection,
+        struct iovec *segments, int count) {
+    if (connection->overflowed) {
+        return -1;
+    }
+    if (reactor->backend == REACTOR_URING) {
+        // Every connection's output is sent at once when the reactor waits.
+        for (int i = 0; i < count; i++) {
+            queue_output(connection, segments[i].iov_base,
+                    segments[i].iov_len);
+        }
+        if (connection->pendingLength + connection->flightLength >
+                reactor->highWater) {
+            connection->overflowed = 1;
+            return -1;
+        }
+        need_attention(reactor, connection);
+        return 0;
+    }
+    ssize_t sent = 0;
+    // Output must stay in order, so nothing jumps the queue.
+    if (connection->pendingLength == 0) {
+        sent = send_without_blocking(connection->fd, segments, count);
+        if (sent == -1) {
+            // The peer is gone, which reading from it will notice.
+            return 0;
+        }
+    }
+    int wasEmpty = connection->pendingLength == 0;
+    for (int i = 0; i < count; i++) {
+        if ((size_t) sent >= segments[i].iov_len) {
+            sent -= segments[i].iov_len;
+            continue;
+        }
+        queue_output(connection, (char *) segments[i].iov_base + sent,
+                segments[i].iov_len - sent);
+        sent = 0;
+    }
+    if (connection->pendingLength > reactor->highWater) {
+        connection->overflowed = 1;
+        return -1;
+    }
+    if (wasEmpty && connection->pendingLength > 0) {
+        watch_output(reactor, connection);
+    }
+    return 0;
+}
+
+/**
+ * Writes queued output to a connection which has become writable.
+ * @param reactor - The reactor the connection is registered with.
+ * @param connection - The connection.
+ */
+static void drain_connection(Reactor *reactor, Connection *connection) {
+    struct iovec segment;
+    segment.iov_base = connection->pending + connection->pendingStart;
+    segment.iov_len = connection->pendingLength;
+    ssize_t sent = send_without_blocking(connection->fd, &segment, 1);
+    if (sent == -1) {
+        sent = connection->pendingLength;
+    }
+    connection->pendingStart += sent;
+    connection->pendingLength -= sent;
+    if (connection->pendingLength == 0) {
+        connection->pendingStart = 0;
+        watch_output(reactor, connection);
+    }
+}
+
+/**
+ * Reads whatever is available on a connection in to its buffer.
+ * @param connection - The connection to read from.
+ */
+static void fill_connection(Connection *connection) {
+    int bytesRead = line_reader_fill(&connection->reader, MSG_DONTWAIT);
+    if (bytesRead == 0 || (bytesRead == -1 && errno != EAGAIN &&
+            errno != EWOULDBLOCK && errno != EINTR && errno != ENOBUFS)) {
+        connection->closed = 1;
+    }
+}
+
+/**
+ * Checks whether the accept queue of a listening socket is full, in which
+ * case the kernel refuses any connection which arrives before it drains.
+ * @param sock - The listening socket.
+ * @return 1 if the queue is full, 0 if not or it could not be checked.
+ */
+static int accept_queue_full(int sock) {
+    struct tcp_info info;
+    socklen_t size = sizeof(info);
+    if (getsockopt(sock, IPPROTO_TCP, TCP_INFO, &info, &size) == -1) {
+        return 0;
+    }
+    // For a listening socket these hold the queue length and its backlog.
+    return info.tcpi_unacked > info.tcpi_sacked;
+}
+
+/**
+ * Accepts every pending connection on a listening socket, so a burst of
+ * connections is taken in one wake up rather than one per wake up.
+ * @param reactor - The reactor the listener is registered with.
+ * @param listener - The listening connection.
+ * @param sock - A socket which has already been accepted, -1 if none.
+ */
+static void accept_pending(Reactor *reactor, Connection *listener,
+        int sock) {
+    AcceptCounters *counters = listener->accepts;
+    int full = counters != NULL && accept_queue_full(listener->fd);
+    unsigned long accepted = 0;
+    int failed = 0;
+    while (!listener->released) {
+        if (sock == -1) {
+            sock = accept4(listener->fd, NULL, NULL,
+                    SOCK_NONBLOCK | SOCK_CLOEXEC);
+        }
+        if (sock != -1) {
+            accepted++;
+            listener->onAccept(reactor, listener, sock);
+            sock = -1;
+        } else if (errno != EINTR && errno != ECONNABORTED) {
+            failed = errno != EAGAIN && errno != EWOULDBLOCK;
+            break;
+        }
+    }
+    if (counters == NULL) {
+        return;
+    }
+    __atomic_fetch_add(&counters->accepted, accepted, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&counters->drains, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&counters->fullDrains, full, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&counters->failures, failed, __ATOMIC_RELAXED);
+}
+
+/**
+ * Handles the completion of a receive on a connection.
+ * @param reactor - The reactor the connection is registered with.
+ * @param connection - The connection.
+ * @param result - The amount of bytes received, or a negative error.
+ */
+static void complete_receive(Reactor *reactor, Connection *connection,
+        int result) {
+    connection->receiving = 0;
+    if (result > 0) {
+        connection->reader.length += result;
+    } else if (result == 0 || (result != -EINTR && result != -EAGAIN)) {
+        connection->closed = 1;
+    }
+    connection->onInput(reactor, connection);
+    need_attention(reactor, connection);
+}
+
+/**
+ * Handles the completion of a send on a connection.
+ * @param reactor - The reactor the connection is registered with.
+ * @param connection - The connection.
+ * @param result - The amount of bytes sent, or a negative error.
+ */
+static void complete_send(Reactor *reactor, Connection *connection,
+        int result) {
+    if (result < 0 && result != -EINTR && result != -EAGAIN) {
+        // The peer is gone, which receiving from it will notice.
+        connection->flightLength = 0;
+        connection->pendingLength = 0;
+        return;
+    }
+    if (result > 0) {
+        connection->flightStart += result;
+        connection->flightLength -= result;
+    }
+    if (connection->flightLength > 0) {
+        arm_send(reactor, connection);
+    } else {
+        connection->flightStart = 0;
+        need_attention(reactor, connection);
+    }
+}
+
+/**
+ * Handles one io_uring completion.
+ * @param reactor - The reactor the operation was submitted on.
+ * @param userData - The user data of the operation.
+ * @param result - The result of the operation.
+ */
+static void complete(Reactor *reactor, uint64_t userData, int result) {
+    int operation = userData & OPERATION_MASK;
+    Connection *connection = (Connection *) (uintptr_t)
+            (userData & ~(uint64_t) OPERATION_MASK);
+    if (operation == OPERATION_IGNORED) {
+        return;
+    }
+    if (connection == NULL) {
+        run_posted(reactor);
+        arm_wake(reactor);
+        return;
+    }
+    connection->operations--;
+    if (connection->released) {
+        if (operation == OPERATION_ACCEPT && result >= 0) {
+            close(result);
+        }
+        return;
+    }
+    switch (operation) {
+        case (OPERATION_ACCEPT):
+            if (result >= 0 || result == -EINTR ||
+                    result == -ECONNABORTED) {
+                accept_pending(reactor, connection, result >= 0 ? result : -1);
+            } else if (connection->accepts != NULL) {
+                __atomic_fetch_add(&connection->accepts->failures, 1,
+                        __ATOMIC_RELAXED);
+            }
+            if (!connection->released) {
+                arm_accept(reactor, connection);
+            }
+            break;
+        case (OPERATION_SEND):
+            complete_send(reactor, connection, result);
+            break;
+        default:
+            complete_receive(reactor, connection, result);
+    }
+}
+
+/**
+ * Runs the event loop on io_uring until reactor->running is cleared. Each
+ * time around, every receive and send which is needed is submitted in the
+ * same system call which waits for completions.
+ * @param reactor - The reactor to run.
+ */
+static void run_uring(Reactor *reactor) {
+    while (reactor->running) {
+        tend_attention(reactor);
+        int timeout = reactor->timers.count > 0 ? TIMER_TICK_MS : -1;
+        if (uring_submit(&reactor->ring, timeout) == -1) {
+            break;
+        }
+        struct io_uring_cqe *cqe;
+        while ((cqe = uring_peek(&reactor->ring)) != NULL) {
+            uint64_t userData = cqe->user_data;
+            int result = cqe->res;
+            uring_advance(&reactor->ring);
+            complete(reactor, userData, result);
+        }
+        timer_wheel_advance(&reactor->timers, reactor);
+        if (reactor->idle != NULL) {
+            reactor->idle(reactor, reactor->idleArg);
+        }
+        free_released(reactor, 0);
+    }
+}
+
+/**
+ * Runs the event loop until reactor->running is cleared.
+ * @param reactor - The reactor to run.
+ */
+void reactor_run(Reactor *reactor) {
+    struct epoll_event events[REACTOR_MAX_EVENTS];
+    reactor->running = 1;
+    if (reactor->backend == REACTOR_URING) {
+        run_uring(reactor);
+        return;
+    }
+    while (reactor->running) {
+        // Only wake up every tick while there are timers to run.
+        int timeout = reactor->timers.count > 0 ? TIMER_TICK_MS : -1;
+        int ready = epoll_wait(reactor->epoll, events, REACTOR_MAX_EVENTS,
+                timeout);
+        if (ready == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        for (int i = 0; i < ready; i++) {
+            Connection *connection = events[i].data.ptr;
+            if (connection == NULL) {
+                run_posted(reactor);
+                continue;
+            }
+            if (connection->released) {
+                continue;
+            }
+            if (connection->onAccept != NULL) {
+                accept_pending(reactor, connection, -1);
+                continue;
+            }
+            if (events[i].events & EPOLLOUT) {
+                drain_connection(reactor, connection);
+            }
+            if (!(events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))) {
+                continue;
+            }
+            fill_connection(connection);
+            if (events[i].events & (EPOLLHUP | EPOLLERR) &&
+                    (connection->paused || connection_has_room(connection))) {
+                connection->closed = 1;
+            }
+            connection->onInput(reactor, connection);
+        }
+        timer_wheel_advance(&reactor->timers, reactor);
+        if (reactor->idle != NULL) {
+            reactor->idle(reactor, reactor->idleArg);
+        }
+        free_released(reactor, 0);
+    }
+}
@@ -0,0 +1,158 @@
+#ifndef REACTOR_H
+#define REACTOR_H
+
+#include <sys/epoll.h>
+#include <sys/uio.h>
+#include "shared.h"
+#include "timer.h"
+#include "uring.h"
+
+#define REACTOR_MAX_EVENTS 64
+// Default amount of output a connection may have queued before it is
+// considered too slow to keep.
+#define REACTOR_HIGH_WATER 65536
+#define REACTOR_URING_ENTRIES 256
+
+/**
+ * Enum for the ways a reactor can wait for sockets.
+ */
+enum ReactorBackend {
+    REACTOR_EPOLL,
+    REACTOR_URING,
+};
+
+typedef struct Reactor Reactor;
+typedef struct Connection Connection;
+
+/**
+ * Callback for a listening socket which has a connection waiting.
+ */
+typedef void (*AcceptHandler)(Reactor *reactor, Connection *listener,
+        int sock);
+
+/**
+ * Callback for a connection which has received input or has been closed
+ * by the peer.
+ */
+typedef void (*InputHandler)(Reactor *reactor, Connection *connection);
+
+/**
+ * Callback for work posted to a reactor from another thread.
+ */
+typedef void (*Task)(Reactor *reactor, void *arg);
+
+/**
+ * Type defination for work waiting to be run by a reactor.
+ */
+typedef struct PostedTask {
+    Task task;
+    void *arg;
+    struct PostedTask *next;
+} PostedTask;
+
+/**
+ * Type defination for counts kept by listening sockets. Full drains counts
+ * the wake ups which found the accept queue full as they started, at most
+ * one per drain. It shows the listener falling behind, but is not a count
+ * of connections the kernel refused, which the kernel keeps as
+ * ListenOverflows. Counts are only ever added to, so many listeners on
+ * different threads may share them.
+ */
+typedef struct {
+    unsigned long accepted;
+    unsigned long drains;
+    unsigned long fullDrains;
+    unsigned long failures;
+} AcceptCounters;
+
+/**
+ * Type defination for a socket watched by a reactor. Listening sockets
+ * have an accept handler, all other sockets have an input handler and a
+ * buffer of bytes received but not yet consumed as lines. Reading can be
+ * paused while lines already buffered wait to be consumed. Output the
+ * socket could not take straight away is queued until it is writable.
+ * With io_uring, output is always queued and the bytes being sent are moved
+ * to the flight buffer, which must not change until the send completes.
+ */
+struct Connection {
+    int fd;
+    int closed;
+    int released;
+    Connection *nextReleased;
+    AcceptHandler onAccept;
+    AcceptCounters *accepts;
+    InputHandler onInput;
+    void *data;
+    int overflowed;
+    int paused;
+    char *pending;
+    int pendingStart;
+    int pendingLength;
+    int pendingCapacity;
+    int operations;
+    int receiving;
+    int attention;
+    Connection *nextAttention;
+    char *flight;
+    int flightStart;
+    int flightLength;
+    int flightCapacity;
+    LineReader reader;
+};
+
+/**
+ * Type defination for an event loop, driven by either epoll or io_uring.
+ * Other threads hand work to the loop through the posted queue, and wake it
+ * with the eventfd. Timers armed on the loop's wheel are run on the loop's
+ * thread. With io_uring, connections which need a receive or send submitted
+ * are listed for attention and submitted together once per loop. The idle
+ * task, if set, is run once per loop after everything ready has been
+ * handled, before the loop waits again. The amount of tasks waiting and of
+ * connections watched are kept so other threads can see how busy it is.
+ */
+struct Reactor {
+    enum ReactorBackend backend;
+    int epoll;
+    Uring ring;
+    Connection *attention;
+    int running;
+    int highWater;
+    Connection *released;
+    TimerWheel timers;
+    int wake;
+    pthread_mutex_t postedLock;
+    PostedTask *posted;
+    PostedTask *postedTail;
+    int postedCount;
+    int connectionCount;
+    Task idle;
+    void *idleArg;
+};
+
+/**
+ * Function prototypes.
+ */
+int reactor_init(Reactor *reactor, enum ReactorBackend backend);
+void reactor_free(Reactor *reactor);
+int set_non_blocking(int sock, int nonBlocking);
+Connection *reactor_listen(Reactor *reactor, int sock, AcceptHandler handler,
+        AcceptCounters *counters, void *data);
+Connection *reactor_watch(Reactor *reactor, int sock, InputHandler handler,
+        void *data);
+void reactor_release(Reactor *reactor, Connection *connection,
+        int closeSocket);
+void reactor_post(Reactor *reactor, Task task, void *arg);
+void reactor_wake(Reactor *reactor);
+int reactor_queue_depth(Reactor *reactor);
+int reactor_connection_count(Reactor *reactor);
+void reactor_arm(Reactor *reactor, Timer *timer, int milliseconds);
+void reactor_disarm(Reactor *reactor, Timer *timer);
+int connection_read_line(Connection *connection, char **line);
+int connection_is_full(Connection *connection);
+int connection_has_room(Connection *connection);
+void connection_pause(Reactor *reactor, Connection *connection, int paused);
+int connection_write(Reactor *reactor, Connection *connection,
+        struct iovec *segments, int count);
+void reactor_run(Reactor *reactor);
+
+#endif
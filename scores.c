@@ -0,0 +1,300 @@
+#include "shared.h"
+#include "scores.h"
+
+/**
+ * Sets up an empty score table.
+ * @param table - The table to setup.
+ */
+void score_table_init(ScoreTable *table) {
+    table->nextOrder = 0;
+    for (int i = 0; i < SCORE_STRIPES; i++) {
+        ScoreStripe *stripe = &table->stripes[i];
+        pthread_mutex_init(&stripe->lock, NULL);
+        stripe->entryCount = 0;
+        stripe->capacity = 0;
+        stripe->version = 0;
+        stripe->slots = NULL;
+    }
+}
+
+/**
+ * Frees memory held by a score table. The players belong to their intern
+ * table.
+ * @param table - The table to free.
+ */
+void score_table_free(ScoreTable *table) {
+    for (int i = 0; i < SCORE_STRIPES; i++) {
+        ScoreStripe *stripe = &table->stripes[i];
+        pthread_mutex_destroy(&stripe->lock);
+        free(stripe->slots);
+    }
+}
+
+/**
+ * Finds the slot of a player in a stripe, or the empty slot where the
+ * player would go. The stripe must have at least one empty slot.
+ * @param stripe - The stripe to search.
+ * @param id - The ID of the player.
+ * @return the slot.
+ */
+static ScoreEntry *find_slot(ScoreStripe *stripe, int id) {
+    // The low bits chose the stripe, so probe with the rest.
+    int mask = stripe->capacity - 1;
+    int index = (id / SCORE_STRIPES) & mask;
+    while (1) {
+        ScoreEntry *slot = &stripe->slots[index];
+        if (slot->player == NULL || slot->player->id == id) {
+            return slot;
+        }
+        index = (index + 1) & mask;
+    }
+}
+
+/**
+ * Doubles the capacity of a stripe, keeping it at most half full.
+ * @param stripe - The stripe to grow.
+ */
+static void grow_stripe(ScoreStripe *stripe) {
+    ScoreEntry *old = stripe->slots;
+    int oldCapacity = stripe->capacity;
+    stripe->capacity = oldCapacity == 0 ? STRIPE_MIN_CAPACITY :
+            oldCapacity * 2;
+    stripe->slots = calloc(stripe->capacity, sizeof(ScoreEntry));
+    for (int i = 0; i < oldCapacity; i++) {
+        if (old[i].player != NULL) {
+            *find_slot(stripe, old[i].player->id) = old[i];
+        }
+    }
+    free(old);
+}
+
+/**
+ * Adds tokens and points to a player's score, adding the player to the
+ * table if they have not been seen before. Safe to call from any thread.
+ * @param table - The table to add to.
+ * @param player - The interned name of the player.
+ * @param tokensTaken - Tokens to add.
+ * @param pointsEarned - Points to add.
+ */
+void score_table_add(ScoreTable *table, InternedName *player,
+        int tokensTaken, int pointsEarned) {
+    ScoreStripe *stripe = &table->stripes[player->id % SCORE_STRIPES];
+    pthread_mutex_lock(&stripe->lock);
+    if ((stripe->entryCount + 1) * 2 > stripe->capacity) {
+        grow_stripe(stripe);
+    }
+    ScoreEntry *slot = find_slot(stripe, player->id);
+    if (slot->player == NULL) {
+        slot->player = player;
+        slot->order = __atomic_fetch_add(&table->nextOrder, 1,
+                __ATOMIC_RELAXED);
+        slot->tokensTaken = 0;
+        slot->pointsEarned = 0;
+        stripe->entryCount++;
+    }
+    slot->tokensTaken += tokensTaken;
+    slot->pointsEarned += pointsEarned;
+    // Only changed under the lock, but read without it.
+    __atomic_store_n(&stripe->version, stripe->version + 1, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&stripe->lock);
+}
+
+/**
+ * Compares the order of two score entries. Used for qsort.
+ * @param a - The first entry.
+ * @param b - The second entry.
+ */
+static int compare_order(const void *a, const void *b) {
+    long orderA = ((ScoreEntry *) a)->order;
+    long orderB = ((ScoreEntry *) b)->order;
+    return (orderA > orderB) - (orderA < orderB);
+}
+
+/**
+ * Copies every entry of a score table, in the order players were first
+ * seen. Each stripe is locked only while it is copied.
+ * @param table - The table to copy.
+ * @param output - Set to a newly allocated array of entries.
+ * @return the number of entries copied.
+ */
+int score_table_collect(ScoreTable *table, ScoreEntry **output) {
+    int count = 0;
+    int capacity = 0;
+    ScoreEntry *entries = NULL;
+    for (int i = 0; i < SCORE_STRIPES; i++) {
+        ScoreStripe *stripe = &table->stripes[i];
+        pthread_mutex_lock(&stripe->lock);
+        if (count + stripe->entryCount > capacity) {
+            capacity = count + stripe->entryCount;
+            entries = realloc(entries, sizeof(ScoreEntry) * capacity);
+        }
+        for (int j = 0; j < stripe->capacity; j++) {
+            if (stripe->slots[j].player != NULL) {
+                entries[count++] = stripe->slots[j];
+            }
+        }
+        pthread_mutex_unlock(&stripe->lock);
+    }
+    qsort(entries, count, sizeof(ScoreEntry), compare_order);
+    *output = entries;
+    return count;
+}
+
+/**
+ * Sets up an empty leaderboard.
+ * @param board - The leaderboard to setup.
+ */
+void leaderboard_init(Leaderboard *board) {
+    score_table_init(&board->totals);
+    pthread_mutex_init(&board->snapshotLock, NULL);
+    for (int i = 0; i < SCORE_STRIPES; i++) {
+        board->copies[i].version = 0;
+        board->copies[i].count = 0;
+        board->copies[i].capacity = 0;
+        board->copies[i].entries = NULL;
+    }
+    board->snapshot = NULL;
+}
+
+/**
+ * Frees memory held by a leaderboard. Readers must be finished with its
+ * snapshots.
+ * @param board - The leaderboard to free.
+ */
+void leaderboard_free(Leaderboard *board) {
+    if (board->snapshot != NULL) {
+        snapshot_release(board->snapshot);
+    }
+    for (int i = 0; i < SCORE_STRIPES; i++) {
+        free(board->copies[i].entries);
+    }
+    pthread_mutex_destroy(&board->snapshotLock);
+    score_table_free(&board->totals);
+}
+
+/**
+ * Adds tokens and points to a player's total. Safe to call from any thread,
+ * and never waits on readers of the leaderboard.
+ * @param board - The leaderboard to add to.
+ * @param player - The interned name of the player.
+ * @param tokensTaken - Tokens to add.
+ * @param pointsEarned - Points to add.
+ */
+void leaderboard_add(Leaderboard *board, InternedName *player,
+        int tokensTaken, int pointsEarned) {
+    score_table_add(&board->totals, player, tokensTaken, pointsEarned);
+}
+
+/**
+ * Copies the entries of a stripe which has changed. The stripe is only
+ * locked while its slots are copied, the rest is done after.
+ * @param stripe - The stripe to copy.
+ * @param copy - The copy to bring up to date.
+ */
+static void copy_stripe(ScoreStripe *stripe, StripeCopy *copy) {
+    pthread_mutex_lock(&stripe->lock);
+    int capacity = stripe->capacity;
+    copy->version = stripe->version;
+    if (capacity > copy->capacity) {
+        copy->capacity = capacity;
+        copy->entries = realloc(copy->entries, sizeof(ScoreEntry) * capacity);
+    }
+    if (capacity > 0) {
+        memcpy(copy->entries, stripe->slots, sizeof(ScoreEntry) * capacity);
+    }
+    pthread_mutex_unlock(&stripe->lock);
+    copy->count = 0;
+    for (int i = 0; i < capacity; i++) {
+        if (copy->entries[i].player != NULL) {
+            copy->entries[copy->count++] = copy->entries[i];
+        }
+    }
+    qsort(copy->entries, copy->count, sizeof(ScoreEntry), compare_order);
+}
+
+/**
+ * Formats the listing of every total on a leaderboard from the copies of
+ * its stripes, merging them in the order players were first seen.
+ * @param board - The leaderboard to list.
+ * @return a snapshot with a single reference.
+ */
+static ScoreSnapshot *build_snapshot(Leaderboard *board) {
+    static const char *header = "Player Name,Total Tokens,Total Points\n";
+    // Each row is the name, two ints, two commas and a newline.
+    size_t size = strlen(header) + 1;
+    int next[SCORE_STRIPES];
+    for (int i = 0; i < SCORE_STRIPES; i++) {
+        StripeCopy *copy = &board->copies[i];
+        for (int j = 0; j < copy->count; j++) {
+            size += strlen(copy->entries[j].player->name) + 2 * 11 + 3;
+        }
+        next[i] = 0;
+    }
+    ScoreSnapshot *snapshot = malloc(sizeof(ScoreSnapshot));
+    snapshot->references = 1;
+    snapshot->text = malloc(size);
+    int length = sprintf(snapshot->text, "%s", header);
+    while (1) {
+        ScoreEntry *entry = NULL;
+        int stripe = -1;
+        for (int i = 0; i < SCORE_STRIPES; i++) {
+            StripeCopy *copy = &board->copies[i];
+            if (next[i] < copy->count && (entry == NULL ||
+                    copy->entries[next[i]].order < entry->order)) {
+                entry = &copy->entries[next[i]];
+                stripe = i;
+            }
+        }
+        if (entry == NULL) {
+            break;
+        }
+        next[stripe]++;
+        length += sprintf(snapshot->text + length, "%s,%i,%i\n",
+                entry->player->name, entry->tokensTaken,
+                entry->pointsEarned);
+    }
+    snapshot->length = length;
+    return snapshot;
+}
+
+/**
+ * Gets an up to date listing of the leaderboard, rebuilding it only if
+ * scores have changed since it was last listed. Stripes which have not
+ * changed are neither locked nor copied again. The caller must release
+ * the snapshot once done with it.
+ * @param board - The leaderboard to list.
+ * @return the snapshot.
+ */
+ScoreSnapshot *leaderboard_acquire(Leaderboard *board) {
+    pthread_mutex_lock(&board->snapshotLock);
+    int changed = board->snapshot == NULL;
+    for (int i = 0; i < SCORE_STRIPES; i++) {
+        ScoreStripe *stripe = &board->totals.stripes[i];
+        if (__atomic_load_n(&stripe->version, __ATOMIC_ACQUIRE) !=
+                board->copies[i].version) {
+            copy_stripe(stripe, &board->copies[i]);
+            changed = 1;
+        }
+    }
+    if (changed) {
+        if (board->snapshot != NULL) {
+            snapshot_release(board->snapshot);
+        }
+        board->snapshot = build_snapshot(board);
+    }
+    ScoreSnapshot *snapshot = board->snapshot;
+    __atomic_fetch_add(&snapshot->references, 1, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&board->snapshotLock);
+    return snapshot;
+}
+
+/**
+ * Gives up a reference to a snapshot, freeing it if it was the last.
+ * @param snapshot - The snapshot to release.
+ */
+void snapshot_release(ScoreSnapshot *snapshot) {
+    if (__atomic_sub_fetch(&snapshot->references, 1, __ATOMIC_ACQ_REL) == 0) {
+        free(snapshot->text);
+        free(snapshot);
+    }
+}
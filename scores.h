@@ -0,0 +1,97 @@
+#ifndef SCORES_H
+#define SCORES_H
+
+#include <pthread.h>
+#include "intern.h"
+
+#define SCORE_STRIPES 16
+#define STRIPE_MIN_CAPACITY 16
+
+/**
+ * Type defination for a score entry. The player is interned, so the entry
+ * stays valid after the game it came from is freed. The order records when
+ * the player was first seen, so tables can be listed in the order players
+ * arrived.
+ */
+typedef struct {
+    InternedName *player;
+    long order;
+    int tokensTaken;
+    int pointsEarned;
+} ScoreEntry;
+
+/**
+ * Type defination for one stripe of a score table. Each stripe is an open
+ * addressing hash map with its own lock, empty slots have no player. The
+ * version counts changes to the stripe, so readers can tell whether it has
+ * changed without taking the lock.
+ */
+typedef struct {
+    pthread_mutex_t lock;
+    int entryCount;
+    int capacity;
+    long version;
+    ScoreEntry *slots;
+} ScoreStripe;
+
+/**
+ * Type defination for a table of score entries keyed by player ID. Players
+ * are spread over the stripes by ID, so games recording moves for
+ * different players rarely wait on each other.
+ */
+typedef struct {
+    long nextOrder;
+    ScoreStripe stripes[SCORE_STRIPES];
+} ScoreTable;
+
+/**
+ * Type defination for an immutable listing of every score. Readers hold a
+ * reference while they send it, and the last reference frees it.
+ */
+typedef struct {
+    int references;
+    int length;
+    char *text;
+} ScoreSnapshot;
+
+/**
+ * Type defination for a copy of the entries of one stripe, in the order
+ * players were first seen, as of a version of the stripe.
+ */
+typedef struct {
+    long version;
+    int count;
+    int capacity;
+    ScoreEntry *entries;
+} StripeCopy;
+
+/**
+ * Type defination for the scores of every player on the server. The totals
+ * are updated as moves are made, and a snapshot of them is only rebuilt
+ * when a reader finds it out of date. Only stripes which have changed
+ * since they were last copied are locked and copied again, so listing the
+ * leaderboard holds up as few moves as it can.
+ */
+typedef struct {
+    ScoreTable totals;
+    pthread_mutex_t snapshotLock;
+    StripeCopy copies[SCORE_STRIPES];
+    ScoreSnapshot *snapshot;
+} Leaderboard;
+
+/**
+ * Function prototypes.
+ */
+void score_table_init(ScoreTable *table);
+void score_table_free(ScoreTable *table);
+void score_table_add(ScoreTable *table, InternedName *player,
+        int tokensTaken, int pointsEarned);
+int score_table_collect(ScoreTable *table, ScoreEntry **output);
+void leaderboard_init(Leaderboard *board);
+void leaderboard_free(Leaderboard *board);
+void leaderboard_add(Leaderboard *board, InternedName *player,
+        int tokensTaken, int pointsEarned);
+ScoreSnapshot *leaderboard_acquire(Leaderboard *board);
+void snapshot_release(ScoreSnapshot *snapshot);
+
+#endif
@@ -0,0 +1,144 @@
+#include "sessions.h"
+
+/**
+ * Sets up an empty session table.
+ * @param table - The table to setup.
+ */
+void session_table_init(SessionTable *table) {
+    pthread_mutex_init(&table->lock, NULL);
+    table->sessionCount = 0;
+    table->capacity = SESSION_TABLE_MIN_CAPACITY;
+    table->buckets = calloc(table->capacity, sizeof(Session *));
+}
+
+/**
+ * Frees a session table and every session left in it.
+ * @param table - The table to free.
+ */
+void session_table_free(SessionTable *table) {
+    for (int i = 0; i < table->capacity; i++) {
+        Session *session = table->buckets[i];
+        while (session != NULL) {
+            Session *next = session->next;
+            free(session->rid);
+            free(session);
+            session = next;
+        }
+    }
+    free(table->buckets);
+    pthread_mutex_destroy(&table->lock);
+}
+
+/**
+ * Finds the link pointing at the session with a reconnect ID, or the end
+ * of its bucket. The table must be locked.
+ * @param table - The table to search.
+ * @param rid - The reconnect ID.
+ * @param hash - The hash of the reconnect ID.
+ * @return the link.
+ */
+static Session **find_link(SessionTable *table, char *rid,
+        unsigned int hash) {
+    Session **link = &table->buckets[hash & (table->capacity - 1)];
+    while (*link != NULL && ((*link)->hash != hash ||
+            strcmp((*link)->rid, rid) != 0)) {
+        link = &(*link)->next;
+    }
+    return link;
+}
+
+/**
+ * Doubles the amount of buckets of a session table. The table must be
+ * locked.
+ * @param table - The table to grow.
+ */
+static void grow_table(SessionTable *table) {
+    Session **old = table->buckets;
+    int oldCapacity = table->capacity;
+    table->capacity *= 2;
+    table->buckets = calloc(table->capacity, sizeof(Session *));
+    for (int i = 0; i < oldCapacity; i++) {
+        Session *session = old[i];
+        while (session != NULL) {
+            Session *next = session->next;
+            Session **bucket =
+                    &table->buckets[session->hash & (table->capacity - 1)];
+            session->next = *bucket;
+            *bucket = session;
+            session = next;
+        }
+    }
+    free(old);
+}
+
+/**
+ * Adds a session, replacing any session with the same reconnect ID.
+ * @param table - The table to add to.
+ * @param rid - The reconnect ID, which is copied.
+ * @param game - The game the player is in.
+ * @param reactor - The reactor of the worker playing the game.
+ * @param playerId - The ID of the player in the game.
+ */
+void session_table_add(SessionTable *table, char *rid, void *game,
+        void *reactor, int playerId) {
+    unsigned int hash = hash_name(rid);
+    pthread_mutex_lock(&table->lock);
+    Session **link = find_link(table, rid, hash);
+    if (*link == NULL) {
+        if (table->sessionCount + 1 > table->capacity) {
+            grow_table(table);
+            link = find_link(table, rid, hash);
+        }
+        Session *session = malloc(sizeof(Session));
+        session->rid = malloc(sizeof(char) * (strlen(rid) + 1));
+        strcpy(session->rid, rid);
+        session->hash = hash;
+        session->next = NULL;
+        *link = session;
+        table->sessionCount++;
+    }
+    (*link)->game = game;
+    (*link)->reactor = reactor;
+    (*link)->playerId = playerId;
+    pthread_mutex_unlock(&table->lock);
+}
+
+/**
+ * Looks up a session by its reconnect ID.
+ * @param table - The table to search.
+ * @param rid - The reconnect ID.
+ * @param output - Set to a copy of the session if it is found, without its
+ * reconnect ID or link.
+ * @return 1 if the session was found, 0 if not.
+ */
+int session_table_find(SessionTable *table, char *rid, Session *output) {
+    unsigned int hash = hash_name(rid);
+    pthread_mutex_lock(&table->lock);
+    Session *session = *find_link(table, rid, hash);
+    if (session != NULL) {
+        *output = *session;
+        output->rid = NULL;
+        output->next = NULL;
+    }
+    pthread_mutex_unlock(&table->lock);
+    return session != NULL;
+}
+
+/**
+ * Removes a session, if there is one with the reconnect ID.
+ * @param table - The table to remove from.
+ * @param rid - The reconnect ID.
+ */
+void session_table_remove(SessionTable *table, char *rid) {
+    unsigned int hash = hash_name(rid);
+    pthread_mutex_lock(&table->lock);
+    Session **link = find_link(table, rid, hash);
+    Session *session = *link;
+    if (session != NULL) {
+        *link = session->next;
+        free(session->rid);
+        free(session);
+        table->sessionCount--;
+    }
+    pthread_mutex_unlock(&table->lock);
+}
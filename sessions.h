@@ -0,0 +1,45 @@
+#ifndef SESSIONS_H
+#define SESSIONS_H
+
+#include "shared.h"
+
+#define SESSION_TABLE_MIN_CAPACITY 64
+
+/**
+ * Type defination for a player of a running game who may reconnect, keyed
+ * by the reconnect ID they were given. The game is owned by the worker
+ * whose reactor is stored, and the session is only removed on that
+ * worker.
+ */
+typedef struct Session {
+    char *rid;
+    unsigned int hash;
+    void *game;
+    void *reactor;
+    int playerId;
+    struct Session *next;
+} Session;
+
+/**
+ * Type defination for a chained hash map of sessions. The table is locked
+ * as it is shared between the threads which accept connections and the
+ * workers playing games.
+ */
+typedef struct {
+    pthread_mutex_t lock;
+    int sessionCount;
+    int capacity;
+    Session **buckets;
+} SessionTable;
+
+/**
+ * Function prototypes.
+ */
+void session_table_init(SessionTable *table);
+void session_table_free(SessionTable *table);
+void session_table_add(SessionTable *table, char *rid, void *game,
+        void *reactor, int playerId);
+int session_table_find(SessionTable *table, char *rid, Session *output);
+void session_table_remove(SessionTable *table, char *rid);
+
+#endif
@@ -115,4 +115,137 @@ int match_seperators(char *str, const int expectedColumn,
         }
     }
     return colAmount == expectedColumn && commaAmount == expectedComma;
-}
\ No newline at end of file
+}
+
+/**
+ * Hashes a name with FNV-1a.
+ * @param name - The name to hash.
+ * @return the hash of the name.
+ */
+unsigned int hash_name(char *name) {
+    unsigned int hash = 2166136261u;
+    for (unsigned char *c = (unsigned char *) name; *c != '\0'; c++) {
+        hash ^= *c;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * Reads a positive whole number setting from the environment.
+ * @param name - The name of the environment variable.
+ * @param fallback - Used when the variable is missing or invalid.
+ * @returns The value of the setting.
+ */
+int get_setting(char *name, int fallback) {
+    char *value = getenv(name);
+    if (value == NULL) {
+        return fallback;
+    }
+    char *end;
+    long setting = strtol(value, &end, 10);
+    if (*value == '\0' || *end != '\0' || setting <= 0 ||
+            setting > INT_MAX) {
+        return fallback;
+    }
+    return (int) setting;
+}
+
+/**
+ * Sets up an empty line reader.
+ * @param reader - The reader to setup.
+ * @param fd - The socket to read from.
+ */
+void line_reader_init(LineReader *reader, int fd) {
+    reader->fd = fd;
+    reader->start = 0;
+    reader->length = 0;
+}
+
+/**
+ * Moves the unread bytes of a line reader to the front of its buffer. Any
+ * line taken from the reader is no longer valid afterwards.
+ * @param reader - The reader to compact.
+ * @return the amount of bytes which can be added to the buffer.
+ */
+int line_reader_compact(LineReader *reader) {
+    if (reader->start > 0) {
+        memmove(reader->buffer, reader->buffer + reader->start,
+                reader->length);
+        reader->start = 0;
+    }
+    return LINE_READER_SIZE - reader->length;
+}
+
+/**
+ * Receives whatever fits in to a line reader's buffer. Bytes not yet taken
+ * as lines are first moved to the front, so lines are never split.
+ * @param reader - The reader to fill.
+ * @param flags - Flags for recv, MSG_DONTWAIT to not block.
+ * @return the number of bytes received, 0 if the peer closed, -1 on error
+ * (errno is ENOBUFS if the buffer is full without a complete line).
+ */
+int line_reader_fill(LineReader *reader, int flags) {
+    int space = line_reader_compact(reader);
+    if (space == 0) {
+        errno = ENOBUFS;
+        return -1;
+    }
+    ssize_t bytesRead = recv(reader->fd, reader->buffer + reader->length,
+            space, flags);
+    if (bytesRead > 0) {
+        reader->length += bytesRead;
+    }
+    return bytesRead;
+}
+
+/**
+ * Takes the next complete line out of a line reader's buffer. The newline
+ * is replaced by a null terminator, and the line stays valid until the
+ * reader is next filled.
+ * @param reader - The reader to take from.
+ * @param line - Set to the start of the line.
+ * @return the length of the line, -1 if no complete line is buffered.
+ */
+int line_reader_next(LineReader *reader, char **line) {
+    char *start = reader->buffer + reader->start;
+    char *end = memchr(start, '\n', reader->length);
+    if (end == NULL) {
+        return -1;
+    }
+    *end = '\0';
+    int length = end - start;
+    reader->start += length + 1;
+    reader->length -= length + 1;
+    *line = start;
+    return length;
+}
+
+/**
+ * Checks if a line reader's buffer is full without holding a complete line,
+ * so the line being read can never fit.
+ * @param reader - The reader to check.
+ * @return 1 if the buffer holds only part of a line which is too long.
+ */
+int line_reader_is_full(LineReader *reader) {
+    return reader->start == 0 && reader->length == LINE_READER_SIZE &&
+            memchr(reader->buffer, '\n', reader->length) == NULL;
+}
+
+/**
+ * Reads the next line, blocking until it has fully arrived.
+ * @param reader - The reader to read from.
+ * @param line - Set to the start of the line, valid until the next read.
+ * @return the length of the line, -1 if the socket closed or failed, or
+ * the line did not fit in the buffer.
+ */
+int line_reader_read(LineReader *reader, char **line) {
+    int length;
+    while ((length = line_reader_next(reader, line)) == -1) {
+        int bytesRead = line_reader_fill(reader, 0);
+        if (bytesRead == 0 || (bytesRead == -1 && errno != EINTR)) {
+            return -1;
+        }
+    }
+    return length;
+}
@@ -19,6 +19,7 @@
 #include <semaphore.h>
 #include <signal.h>
 #include <errno.h>
+#include <limits.h>
 
 /**
  * A3 includes.
@@ -35,6 +36,8 @@
 #define LEFT 0
 #define RIGHT 1
 
+#define LINE_READER_SIZE 1024
+
 enum Error {
     NORMAL_EXIT = 0,
     INVALID_ARG_NUM = 1,
@@ -46,8 +49,10 @@ enum Error {
     INVALID_SERVER = 4,
     CONNECT_ERR_PLAYER = 5,
     BAD_TIMEOUT = 5,
+    BAD_COUNT = 5,
     FAILED_LISTEN = 6,
     BAD_AUTH = 6,
+    BAD_BOTS = 6,
     BAD_RID = 7,
     COMM_ERR = 8,
     PLAYER_DISCONNECTED = 9,
@@ -55,6 +60,17 @@ enum Error {
     INVALID_MESSAGE = 10
 };
 
+/**
+ * Type defination for a buffered reader of newline terminated lines from
+ * a socket. Lines are handed out in place, so reading never allocates.
+ */
+typedef struct {
+    int fd;
+    int start;
+    int length;
+    char buffer[LINE_READER_SIZE];
+} LineReader;
+
 /**
  * Function Prototypes.
  **/
@@ -64,6 +80,14 @@ int is_string_digit(char *);
 char **split(char *, char *);
 int check_encoded(char **, int);
 int match_seperators(char *, const int, const int);
+unsigned int hash_name(char *);
+int get_setting(char *, int);
+void line_reader_init(LineReader *, int);
+int line_reader_compact(LineReader *);
+int line_reader_fill(LineReader *, int);
+int line_reader_next(LineReader *, char **);
+int line_reader_is_full(LineReader *);
+int line_reader_read(LineReader *, char **);
 
 #endif
 
@@ -0,0 +1,654 @@
+#include "sim.h"
+
+// The bots games can be simulated with, by the name used in BOTS_ENV.
+static Bot bots[] = {
+    {"greedy", choose_greedy},
+    {"thrifty", choose_thrifty},
+    {"random", choose_random},
+};
+
+#define BOT_COUNT ((int) (sizeof(bots) / sizeof(Bot)))
+#define DEFAULT_LINEUP "greedy,thrifty,random"
+
+/**
+ * Exits the program with a error.
+ * @param int - Error code.
+ */
+void exit_with_error(int error) {
+    switch(error) {
+        case INVALID_ARG_NUM:
+            fprintf(stderr, "Usage: rafiki-sim deckfile statfile games "\
+                    "threads\n");
+            break;
+        case INVALID_DECKFILE:
+            fprintf(stderr, "Bad deckfile\n");
+            break;
+        case INVALID_STATFILE:
+            fprintf(stderr, "Bad statfile\n");
+            break;
+        case BAD_COUNT:
+            fprintf(stderr, "Bad count\n");
+            break;
+        case BAD_BOTS:
+            fprintf(stderr, "Bad bots\n");
+            break;
+        case SYSTEM_ERR:
+            fprintf(stderr, "System error\n");
+            break;
+    }
+    exit(error);
+}
+
+/**
+ * Checks initial arguments for rafiki-sim.
+ * @param argc - Argument count.
+ * @param argv - Argument vector.
+ */
+void check_args(int argc, char **argv) {
+    if (argc != SIM_EXPECTED_ARGC) {
+        exit_with_error(INVALID_ARG_NUM);
+    }
+    for (int i = SIM_GAMES; i <= SIM_THREADS; i++) {
+        if (strcmp(argv[i], "") == 0 || !is_string_digit(argv[i]) ||
+                strlen(argv[i]) > 9) {
+            exit_with_error(BAD_COUNT);
+        }
+    }
+}
+
+/**
+ * Gets the bot playing from a seat of a game.
+ * @param sim - The simulation.
+ * @param number - The number of the game within the simulation.
+ * @param seat - The ID of the player.
+ * @returns The index of the bot.
+ */
+int get_seat_bot(Simulation *sim, long number, int seat) {
+    return sim->lineup[(number + seat) % sim->lineupSize];
+}
+
+/**
+ * Works out the tokens a player would spend buying a card, using their own
+ * tokens before any wild ones.
+ * @param player - The player buying the card.
+ * @param card - The card.
+ * @param costs - Filled with the amount of each token spent.
+ * @returns 0 if the player can afford the card.
+ */
+int get_costs(struct Player *player, struct Card card, int *costs) {
+    costs[TOKEN_WILD] = 0;
+    for (int i = 0; i < TOKEN_MAX - 1; i++) {
+        int need = max(card.cost[i] - player->discounts[i], 0);
+        costs[i] = need < player->tokens[i] ? need : player->tokens[i];
+        costs[TOKEN_WILD] += need - costs[i];
+    }
+    return validate_costs(*player, card, costs);
+}
+
+/**
+ * Writes a purchase move.
+ * @param line - The buffer to write to.
+ * @param cardNumber - The position of the card on the board.
+ * @param costs - The amount of each token spent.
+ */
+void write_purchase(char *line, int cardNumber, int *costs) {
+    snprintf(line, SIM_LINE_SIZE, "purchase%d:%d,%d,%d,%d,%d", cardNumber,
+            costs[TOKEN_PURPLE], costs[TOKEN_BROWN], costs[TOKEN_YELLOW],
+            costs[TOKEN_RED], costs[TOKEN_WILD]);
+}
+
+/**
+ * Writes a take move, taking one token from each of the first piles in an
+ * order which still have tokens.
+ * @param line - The buffer to write to.
+ * @param game - The game being played.
+ * @param order - The non wild piles, most wanted first.
+ * @returns 0 on success, -1 if too few piles have tokens left.
+ */
+int write_take(char *line, struct Game *game, int *order) {
+    int tokens[TOKEN_MAX - 1] = {0};
+    int taken = 0;
+    for (int i = 0; i < TOKEN_MAX - 1 && taken < TAKE_NUMBER; i++) {
+        if (game->tokenCount[order[i]] > 0) {
+            tokens[order[i]] = 1;
+            taken++;
+        }
+    }
+    if (taken < TAKE_NUMBER) {
+        return -1;
+    }
+    snprintf(line, SIM_LINE_SIZE, "take%d,%d,%d,%d", tokens[TOKEN_PURPLE],
+            tokens[TOKEN_BROWN], tokens[TOKEN_YELLOW], tokens[TOKEN_RED]);
+    return 0;
+}
+
+/**
+ * Sorts the non wild piles by weight, heaviest first. Piles with the same
+ * weight keep the order they were given in.
+ * @param weights - The weight of each pile.
+ * @param order - The piles, which are sorted in place.
+ */
+void order_piles(int *weights, int *order) {
+    for (int i = 1; i < TOKEN_MAX - 1; i++) {
+        int pile = order[i];
+        int j = i;
+        while (j > 0 && weights[order[j - 1]] < weights[pile]) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = pile;
+    }
+}
+
+/**
+ * Chooses a move for a bot which buys the card worth the most points it
+ * can afford, picking at random between cards worth as many points, and
+ * otherwise takes from the fullest piles.
+ * @param game - The game being played.
+ * @param playerId - The ID of the bot's player.
+ * @param seed - The seed for breaking ties between cards.
+ * @param line - Filled with the move.
+ */
+void choose_greedy(struct Game *game, int playerId, unsigned int *seed,
+        char *line) {
+    struct Player *player = &game->players[playerId].state;
+    int best = -1, ties = 0, bestCosts[TOKEN_MAX];
+    for (int i = 0; i < game->boardSize; i++) {
+        int costs[TOKEN_MAX];
+        if (get_costs(player, game->board[i], costs) != 0) {
+            continue;
+        }
+        if (best == -1 || game->board[i].points > game->board[best].points) {
+            ties = 0;
+        } else if (game->board[i].points < game->board[best].points) {
+            continue;
+        }
+        // Each of the cards tied so far is kept with the same chance.
+        if (rand_r(seed) % ++ties == 0) {
+            best = i;
+            memcpy(bestCosts, costs, sizeof(costs));
+        }
+    }
+    if (best != -1) {
+        write_purchase(line, best, bestCosts);
+        return;
+    }
+    int order[TOKEN_MAX - 1] = {TOKEN_PURPLE, TOKEN_BROWN, TOKEN_YELLOW,
+            TOKEN_RED};
+    order_piles(game->tokenCount, order);
+    if (write_take(line, game, order) == -1) {
+        strcpy(line, "wild");
+    }
+}
+
+/**
+ * Chooses a move for a bot which buys whatever card costs it the fewest
+ * tokens, counting wild tokens twice, and otherwise takes the tokens the
+ * cheapest card on the board is missing.
+ * @param game - The game being played.
+ * @param playerId - The ID of the bot's player.
+ * @param seed - Unused.
+ * @param line - Filled with the move.
+ */
+void choose_thrifty(struct Game *game, int playerId, unsigned int *seed,
+        char *line) {
+    struct Player *player = &game->players[playerId].state;
+    int best = -1, bestSpent = INT_MAX, bestCosts[TOKEN_MAX];
+    int target = -1, targetMissing = INT_MAX, need[TOKEN_MAX - 1];
+    for (int i = 0; i < game->boardSize; i++) {
+        int costs[TOKEN_MAX];
+        int affordable = get_costs(player, game->board[i], costs) == 0;
+        int spent = costs[TOKEN_WILD] * 2;
+        for (int j = 0; j < TOKEN_MAX - 1; j++) {
+            spent += costs[j];
+        }
+        if (affordable && (spent < bestSpent || (spent == bestSpent &&
+                game->board[i].points > game->board[best].points))) {
+            best = i;
+            bestSpent = spent;
+            memcpy(bestCosts, costs, sizeof(costs));
+        }
+        // Wild tokens are what a card is missing once own tokens are used.
+        if (costs[TOKEN_WILD] < targetMissing) {
+            target = i;
+            targetMissing = costs[TOKEN_WILD];
+        }
+    }
+    if (best != -1) {
+        write_purchase(line, best, bestCosts);
+        return;
+    }
+    int order[TOKEN_MAX - 1] = {TOKEN_PURPLE, TOKEN_BROWN, TOKEN_YELLOW,
+            TOKEN_RED};
+    order_piles(game->tokenCount, order);
+    if (target != -1) {
+        struct Card card = game->board[target];
+        for (int i = 0; i < TOKEN_MAX - 1; i++) {
+            need[i] = max(card.cost[i] - player->discounts[i] -
+                    player->tokens[i], 0);
+        }
+        order_piles(need, order);
+    }
+    if (write_take(line, game, order) == -1) {
+        strcpy(line, "wild");
+    }
+}
+
+/**
+ * Chooses a move for a bot which picks evenly between every card it can
+ * afford, taking from random piles and taking a wild token.
+ * @param game - The game being played.
+ * @param playerId - The ID of the bot's player.
+ * @param seed - The random state of the game.
+ * @param line - Filled with the move.
+ */
+void choose_random(struct Game *game, int playerId, unsigned int *seed,
+        char *line) {
+    struct Player *player = &game->players[playerId].state;
+    int affordable[BOARD_SIZE], costs[BOARD_SIZE][TOKEN_MAX], count = 0;
+    for (int i = 0; i < game->boardSize; i++) {
+        if (get_costs(player, game->board[i], costs[count]) == 0) {
+            affordable[count++] = i;
+        }
+    }
+    int order[TOKEN_MAX - 1] = {TOKEN_PURPLE, TOKEN_BROWN, TOKEN_YELLOW,
+            TOKEN_RED};
+    for (int i = TOKEN_MAX - 2; i > 0; i--) {
+        int j = rand_r(seed) % (i + 1);
+        int pile = order[i];
+        order[i] = order[j];
+        order[j] = pile;
+    }
+    char take[SIM_LINE_SIZE];
+    int canTake = write_take(take, game, order) == 0;
+    int choice = rand_r(seed) % (count + canTake + 1);
+    if (choice < count) {
+        write_purchase(line, affordable[choice], costs[choice]);
+    } else if (canTake && choice == count) {
+        strcpy(line, take);
+    } else {
+        strcpy(line, "wild");
+    }
+}
+
+/**
+ * Finds a bot by name.
+ * @param name - The name of the bot.
+ * @returns The index of the bot, -1 if there is no such bot.
+ */
+int find_bot(char *name) {
+    for (int i = 0; i < BOT_COUNT; i++) {
+        if (strcmp(bots[i].name, name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Reads the bots to seat in each game from the environment, as a comma
+ * separated list of names. Every bot is seated once when it is not set.
+ * @param size - Set to the amount of bots in the lineup.
+ * @returns The index of each bot, NULL if a name is not a bot.
+ */
+int *read_lineup(int *size) {
+    char *value = getenv(BOTS_ENV);
+    char *names = malloc(strlen(value == NULL ? DEFAULT_LINEUP : value) + 1);
+    strcpy(names, value == NULL ? DEFAULT_LINEUP : value);
+    int *lineup = NULL;
+    char *cursor = names, *name;
+    *size = 0;
+    while ((name = strsep(&cursor, ",")) != NULL) {
+        int bot = find_bot(name);
+        if (bot == -1) {
+            free(lineup);
+            free(names);
+            return NULL;
+        }
+        lineup = realloc(lineup, sizeof(int) * (*size + 1));
+        lineup[(*size)++] = bot;
+    }
+    free(names);
+    return lineup;
+}
+
+/**
+ * Sets up empty results.
+ * @param results - The results to setup.
+ */
+void results_init(SimResults *results) {
+    results->games = 0;
+    results->moves = 0;
+    results->rounds = 0;
+    results->byPoints = 0;
+    results->byDeck = 0;
+    results->stalled = 0;
+    results->errors = 0;
+    results->seats = calloc(BOT_COUNT, sizeof(unsigned long));
+    results->wins = calloc(BOT_COUNT, sizeof(unsigned long));
+    results->points = calloc(BOT_COUNT, sizeof(unsigned long));
+}
+
+/**
+ * Adds one set of results to another.
+ * @param into - The results to add to.
+ * @param from - The results to add.
+ */
+void results_add(SimResults *into, SimResults *from) {
+    into->games += from->games;
+    into->moves += from->moves;
+    into->rounds += from->rounds;
+    into->byPoints += from->byPoints;
+    into->byDeck += from->byDeck;
+    into->stalled += from->stalled;
+    into->errors += from->errors;
+    for (int i = 0; i < BOT_COUNT; i++) {
+        into->seats[i] += from->seats[i];
+        into->wins[i] += from->wins[i];
+        into->points[i] += from->points[i];
+    }
+}
+
+/**
+ * Frees memory allocated to results.
+ * @param results - The results to free.
+ */
+void results_free(SimResults *results) {
+    free(results->seats);
+    free(results->wins);
+    free(results->points);
+}
+
+/**
+ * Sets up a game the way rafiki starts one, with the thread's own copy of
+ * the deck. Every player writes to the thread's sink, so whatever the
+ * library sends never leaves the process.
+ * @param worker - The thread playing the game.
+ * @param game - The game to setup.
+ * @param number - The number of the game within the simulation.
+ * @param seed - The random state of the game.
+ */
+void deal_game(SimWorker *worker, struct Game *game, long number,
+        unsigned int *seed) {
+    Simulation *sim = worker->sim;
+    game->name = "sim";
+    game->winScore = sim->stat.points;
+    game->playerCount = sim->stat.players;
+    game->players = worker->players;
+    for (int i = 0; i < game->playerCount; i++) {
+        struct GamePlayer *player = &worker->players[i];
+        initialize_player(&player->state, i);
+        player->state.name = bots[get_seat_bot(sim, number, i)].name;
+        player->fileDescriptor = -1;
+        player->toPlayer = worker->sink;
+        player->fromPlayer = NULL;
+    }
+    memcpy(worker->deck, sim->deck->cards,
+            sizeof(struct Card) * sim->deck->size);
+    if (sim->shuffle) {
+        for (int i = sim->deck->size - 1; i > 0; i--) {
+            int j = rand_r(seed) % (i + 1);
+            struct Card card = worker->deck[i];
+            worker->deck[i] = worker->deck[j];
+            worker->deck[j] = card;
+        }
+    }
+    game->deck = worker->deck;
+    game->deckSize = sim->deck->size;
+    game->boardSize = 0;
+    game->data = NULL;
+    for (int i = 0; i < TOKEN_MAX - 1; i++) {
+        game->tokenCount[i] = sim->stat.tokens;
+    }
+    refill_board(worker, game);
+}
+
+/**
+ * Plays one move through the library, as the hub does with a line from a
+ * player.
+ * @param game - The game being played.
+ * @param playerId - The ID of the player.
+ * @param line - The move.
+ * @return a error code depending on whether if the move is valid.
+ */
+enum ErrorCode play_move(struct Game *game, int playerId, char *line) {
+    switch(classify_from_player(line)) {
+        case PURCHASE:
+            return handle_purchase_message(playerId, game, line);
+        case TAKE:
+            return handle_take_message(playerId, game, line);
+        case WILD:
+            handle_wild_message(playerId, game);
+            return NOTHING_WRONG;
+        default:
+            return PROTOCOL_ERROR;
+    }
+}
+
+/**
+ * Draws cards until the board is full or the deck runs out, then discards
+ * everything the library has sent to the players.
+ * @param worker - The thread playing the game.
+ * @param game - The game being played.
+ */
+void refill_board(SimWorker *worker, struct Game *game) {
+    while (game->boardSize < BOARD_SIZE && game->deckSize > 0) {
+        draw_card(game);
+    }
+    rewind(worker->sink);
+}
+
+/**
+ * Records how a finished game went. Every player on the highest score wins.
+ * @param worker - The thread which played the game.
+ * @param game - The game.
+ * @param number - The number of the game within the simulation.
+ */
+void score_game(SimWorker *worker, struct Game *game, long number) {
+    SimResults *results = &worker->results;
+    int highest = 0;
+    for (int i = 0; i < game->playerCount; i++) {
+        highest = max(highest, game->players[i].state.score);
+    }
+    for (int i = 0; i < game->playerCount; i++) {
+        int bot = get_seat_bot(worker->sim, number, i);
+        int score = game->players[i].state.score;
+        results->seats[bot]++;
+        results->points[bot] += score;
+        if (score == highest) {
+            results->wins[bot]++;
+        }
+    }
+    if (highest >= game->winScore) {
+        results->byPoints++;
+    } else {
+        results->byDeck++;
+    }
+    results->games++;
+}
+
+/**
+ * Plays one game from start to finish. The random state is worked out
+ * from the game's number, so results do not depend on the amount of
+ * threads.
+ * @param worker - The thread playing the game.
+ * @param number - The number of the game within the simulation.
+ */
+void simulate_game(SimWorker *worker, long number) {
+    SimResults *results = &worker->results;
+    unsigned int seed = worker->sim->seed + (unsigned int) number *
+            2654435761u;
+    struct Game game;
+    deal_game(worker, &game, number, &seed);
+    int rounds = 0;
+    while (!is_game_over(&game)) {
+        if (rounds == SIM_MAX_ROUNDS) {
+            results->stalled++;
+            return;
+        }
+        for (int i = 0; i < game.playerCount; i++) {
+            char line[SIM_LINE_SIZE];
+            bots[get_seat_bot(worker->sim, number, i)].choose(&game, i, &seed,
+                    line);
+            if (play_move(&game, i, line) != NOTHING_WRONG) {
+                results->errors++;
+                return;
+            }
+            results->moves++;
+            refill_board(worker, &game);
+        }
+        rounds++;
+    }
+    results->rounds += rounds;
+    score_game(worker, &game, number);
+}
+
+/**
+ * A thread which plays games of a simulation until there are none left.
+ * @param arg - The SimWorker type.
+ */
+void *sim_thread(void *arg) {
+    SimWorker *worker = (SimWorker *) arg;
+    Simulation *sim = worker->sim;
+    while (1) {
+        long first = __atomic_fetch_add(&sim->nextGame, SIM_BATCH,
+                __ATOMIC_RELAXED);
+        if (first >= sim->gameTotal) {
+            return NULL;
+        }
+        long last = first + SIM_BATCH < sim->gameTotal ? first + SIM_BATCH :
+                sim->gameTotal;
+        for (long i = first; i < last; i++) {
+            simulate_game(worker, i);
+        }
+    }
+}
+
+/**
+ * Plays every game of a simulation, spread over a number of threads, and
+ * adds up what each thread saw.
+ * @param sim - The simulation.
+ * @param threadAmount - The amount of threads to play on.
+ */
+void run_simulation(Simulation *sim, int threadAmount) {
+    SimWorker *workers = malloc(sizeof(SimWorker) * threadAmount);
+    uint64_t start = latency_now();
+    for (int i = 0; i < threadAmount; i++) {
+        SimWorker *worker = &workers[i];
+        worker->sim = sim;
+        worker->deck = malloc(sizeof(struct Card) * (sim->deck->size + 1));
+        worker->sink = fmemopen(worker->sinkBuffer, SIM_SINK_SIZE, "w");
+        if (worker->sink == NULL) {
+            exit_with_error(SYSTEM_ERR);
+        }
+        results_init(&worker->results);
+        if (pthread_create(&worker->thread, NULL, sim_thread, worker)) {
+            exit_with_error(SYSTEM_ERR);
+        }
+    }
+    for (int i = 0; i < threadAmount; i++) {
+        SimWorker *worker = &workers[i];
+        pthread_join(worker->thread, NULL);
+        results_add(&sim->results, &worker->results);
+        results_free(&worker->results);
+        fclose(worker->sink);
+        free(worker->deck);
+    }
+    sim->elapsed = latency_now() - start;
+    free(workers);
+}
+
+/**
+ * Prints the results of every simulation to stdout. Throughput comes first,
+ * then how well each bot did.
+ * @param sims - The simulations, one for each line of the statfile.
+ * @param amount - The amount of simulations.
+ */
+void print_results(Simulation *sims, int amount) {
+    printf("Port,Players,Tokens,Points,Games,Moves,Seconds,Games Per Second,"
+            "Moves Per Second,Average Rounds,Won On Points,Deck Ran Out,"
+            "Stalled,Bot Errors\n");
+    for (int i = 0; i < amount; i++) {
+        SimResults *results = &sims[i].results;
+        double seconds = sims[i].elapsed / 1000000.0;
+        printf("%s,%d,%d,%d,%lu,%lu,%.3f,%.1f,%.1f,%.2f,%lu,%lu,%lu,%lu\n",
+                sims[i].stat.port, sims[i].stat.players, sims[i].stat.tokens,
+                sims[i].stat.points, results->games, results->moves, seconds,
+                seconds <= 0 ? 0 : results->games / seconds,
+                seconds <= 0 ? 0 : results->moves / seconds,
+                results->games == 0 ? 0 :
+                (double) results->rounds / results->games,
+                results->byPoints, results->byDeck, results->stalled,
+                results->errors);
+    }
+    printf("Port,Bot,Seats,Wins,Win Rate,Average Points\n");
+    for (int i = 0; i < amount; i++) {
+        SimResults *results = &sims[i].results;
+        for (int bot = 0; bot < BOT_COUNT; bot++) {
+            unsigned long seats = results->seats[bot];
+            if (seats == 0) {
+                continue;
+            }
+            printf("%s,%s,%lu,%lu,%.4f,%.2f\n", sims[i].stat.port,
+                    bots[bot].name, seats, results->wins[bot],
+                    (double) results->wins[bot] / seats,
+                    (double) results->points[bot] / seats);
+        }
+    }
+}
+
+/**
+ * Main. Plays games between bots for each line of a statfile, entirely in
+ * memory, and reports how fast the engine played them and how each bot
+ * did.
+ */
+int main(int argc, char **argv) {
+    check_args(argc, argv);
+    SharedDeck *deck = read_deckfile(argv[SIM_DECKFILE]);
+    if (deck == NULL) {
+        exit_with_error(INVALID_DECKFILE);
+    }
+    StatFileProp prop;
+    if (read_statfile(argv[SIM_STATFILE], &prop) == -1) {
+        exit_with_error(INVALID_STATFILE);
+    }
+    for (int i = 0; i < prop.amount; i++) {
+        if (prop.stats[i].players < 1 ||
+                prop.stats[i].players > MAX_PLAYERS) {
+            exit_with_error(INVALID_STATFILE);
+        }
+    }
+    int lineupSize;
+    int *lineup = read_lineup(&lineupSize);
+    if (lineup == NULL) {
+        exit_with_error(BAD_BOTS);
+    }
+    int threadAmount = atoi(argv[SIM_THREADS]);
+    if (threadAmount == 0) {
+        threadAmount = max(sysconf(_SC_NPROCESSORS_ONLN), 1);
+    }
+    Simulation *sims = malloc(sizeof(Simulation) * prop.amount);
+    for (int i = 0; i < prop.amount; i++) {
+        Simulation *sim = &sims[i];
+        sim->deck = deck;
+        sim->stat = prop.stats[i];
+        sim->lineup = lineup;
+        sim->lineupSize = lineupSize;
+        sim->shuffle = get_setting(SHUFFLE_ENV, 0);
+        sim->seed = get_setting(SEED_ENV, 1);
+        sim->gameTotal = atol(argv[SIM_GAMES]);
+        sim->nextGame = 0;
+        results_init(&sim->results);
+        run_simulation(sim, threadAmount);
+    }
+    print_results(sims, prop.amount);
+    for (int i = 0; i < prop.amount; i++) {
+        results_free(&sims[i].results);
+        free(prop.stats[i].port);
+    }
+    free(sims);
+    free(prop.stats);
+    free(lineup);
+    shared_deck_release(deck);
+    return 0;
+}
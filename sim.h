@@ -0,0 +1,130 @@
+#ifndef SIM_H
+#define SIM_H
+
+#include "shared.h"
+#include "decks.h"
+#include "statfile.h"
+#include "latency.h"
+
+#define SIM_EXPECTED_ARGC 5
+
+// Settings which do not fit the fixed arguments are read from the
+// environment.
+#define BOTS_ENV "RAFIKI_SIM_BOTS"
+#define SEED_ENV "RAFIKI_SIM_SEED"
+#define SHUFFLE_ENV "RAFIKI_SIM_SHUFFLE"
+
+// Games are handed to threads this many at a time, so threads rarely touch
+// the shared counter.
+#define SIM_BATCH 64
+// A game still going after this many rounds is given up on as stalled.
+#define SIM_MAX_ROUNDS 10000
+// Large enough for everything the library sends to every player in one
+// move.
+#define SIM_SINK_SIZE 8192
+// Large enough for any move a bot makes.
+#define SIM_LINE_SIZE 64
+
+/**
+ * Enum for rafiki-sim arguments.
+ */
+enum Argument {
+    SIM_DECKFILE = 1,
+    SIM_STATFILE = 2,
+    SIM_GAMES = 3,
+    SIM_THREADS = 4
+};
+
+/**
+ * Type defination for a bot which plays in simulated games. A bot sees the
+ * whole game as the hub does and writes the line it would send in reply to
+ * dowhat, which is then played through the same library calls as a move
+ * from a real player.
+ */
+typedef struct {
+    char *name;
+    void (*choose)(struct Game *game, int playerId, unsigned int *seed,
+            char *line);
+} Bot;
+
+/**
+ * Type defination for what a thread saw in the games it simulated. Each
+ * thread keeps its own and they are added together once every thread is
+ * done, so playing a game touches nothing shared.
+ */
+typedef struct {
+    unsigned long games;
+    unsigned long moves;
+    unsigned long rounds;
+    unsigned long byPoints;
+    unsigned long byDeck;
+    unsigned long stalled;
+    unsigned long errors;
+    unsigned long *seats;
+    unsigned long *wins;
+    unsigned long *points;
+} SimResults;
+
+/**
+ * Type defination for simulating one line of a statfile. The lineup is
+ * the bots seated in each game, rotated by one seat every game so each bot
+ * plays from every seat.
+ */
+typedef struct {
+    SharedDeck *deck;
+    Stat stat;
+    int *lineup;
+    int lineupSize;
+    int shuffle;
+    unsigned int seed;
+    long gameTotal;
+    long nextGame;
+    uint64_t elapsed;
+    SimResults results;
+} Simulation;
+
+/**
+ * Type defination for one thread playing the games of a simulation.
+ */
+typedef struct {
+    Simulation *sim;
+    pthread_t thread;
+    FILE *sink;
+    char sinkBuffer[SIM_SINK_SIZE];
+    struct Card *deck;
+    struct GamePlayer players[MAX_PLAYERS];
+    SimResults results;
+} SimWorker;
+
+/**
+ * Function prototypes.
+ */
+void exit_with_error(int error);
+void check_args(int argc, char **argv);
+int get_seat_bot(Simulation *sim, long number, int seat);
+int get_costs(struct Player *player, struct Card card, int *costs);
+void write_purchase(char *line, int cardNumber, int *costs);
+int write_take(char *line, struct Game *game, int *order);
+void order_piles(int *weights, int *order);
+void choose_greedy(struct Game *game, int playerId, unsigned int *seed,
+        char *line);
+void choose_thrifty(struct Game *game, int playerId, unsigned int *seed,
+        char *line);
+void choose_random(struct Game *game, int playerId, unsigned int *seed,
+        char *line);
+int find_bot(char *name);
+int *read_lineup(int *size);
+void results_init(SimResults *results);
+void results_add(SimResults *into, SimResults *from);
+void results_free(SimResults *results);
+void deal_game(SimWorker *worker, struct Game *game, long number,
+        unsigned int *seed);
+enum ErrorCode play_move(struct Game *game, int playerId, char *line);
+void refill_board(SimWorker *worker, struct Game *game);
+void score_game(SimWorker *worker, struct Game *game, long number);
+void simulate_game(SimWorker *worker, long number);
+void *sim_thread(void *arg);
+void run_simulation(Simulation *sim, int threadAmount);
+void print_results(Simulation *sims, int amount);
+
+#endif
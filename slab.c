@@ -0,0 +1,185 @@
+#include "slab.h"
+
+/**
+ * Sets up an empty slab.
+ * @param slab - The slab to setup.
+ * @param arenaSize - The amount of bytes each game is expected to need.
+ */
+void slab_init(GameSlab *slab, size_t arenaSize) {
+    pthread_mutex_init(&slab->lock, NULL);
+    slab->slotCount = 0;
+    slab->inUseCount = 0;
+    slab->freeSlot = -1;
+    slab->arenaSize = arenaSize;
+    slab->chunks = NULL;
+}
+
+/**
+ * Frees the memory of a slab, including the arenas of games still in use.
+ * Anything else held by those games is not freed.
+ * @param slab - The slab to free.
+ */
+void slab_free(GameSlab *slab) {
+    for (int i = 0; i < slab->slotCount / SLAB_CHUNK_SIZE; i++) {
+        for (int j = 0; j < SLAB_CHUNK_SIZE; j++) {
+            arena_free(&slab->chunks[i][j].arena);
+        }
+        free(slab->chunks[i]);
+    }
+    free(slab->chunks);
+    pthread_mutex_destroy(&slab->lock);
+}
+
+/**
+ * Gets a slot by its number. The slab must be locked.
+ * @param slab - The slab.
+ * @param slot - The number of the slot.
+ * @return the slot.
+ */
+static GameSlot *get_slot(GameSlab *slab, int slot) {
+    return &slab->chunks[slot / SLAB_CHUNK_SIZE][slot % SLAB_CHUNK_SIZE];
+}
+
+/**
+ * Adds a chunk of free slots to a slab. The slab must be locked.
+ * @param slab - The slab to grow.
+ */
+static void grow_slab(GameSlab *slab) {
+    int chunkCount = slab->slotCount / SLAB_CHUNK_SIZE;
+    slab->chunks = realloc(slab->chunks, sizeof(GameSlot *) *
+            (chunkCount + 1));
+    GameSlot *chunk = malloc(sizeof(GameSlot) * SLAB_CHUNK_SIZE);
+    // Link the new slots so the lowest is handed out first.
+    for (int i = 0; i < SLAB_CHUNK_SIZE; i++) {
+        arena_init(&chunk[i].arena, slab->arenaSize);
+        chunk[i].generation = 0;
+        chunk[i].inUse = 0;
+        chunk[i].nextFree = i == SLAB_CHUNK_SIZE - 1 ? slab->freeSlot :
+                slab->slotCount + i + 1;
+    }
+    slab->chunks[chunkCount] = chunk;
+    slab->freeSlot = slab->slotCount;
+    slab->slotCount += SLAB_CHUNK_SIZE;
+}
+
+/**
+ * Takes a free slot of the slab for a new game, which the caller then sets
+ * up in place with memory from the slot's arena.
+ * @param slab - The slab to store in.
+ * @return the number of the slot taken.
+ */
+int slab_alloc(GameSlab *slab) {
+    pthread_mutex_lock(&slab->lock);
+    if (slab->freeSlot == -1) {
+        grow_slab(slab);
+    }
+    int slot = slab->freeSlot;
+    GameSlot *gameSlot = get_slot(slab, slot);
+    slab->freeSlot = gameSlot->nextFree;
+    gameSlot->inUse = 1;
+    slab->inUseCount++;
+    pthread_mutex_unlock(&slab->lock);
+    return slot;
+}
+
+/**
+ * Gets the game stored in a slot which is known to be in use.
+ * @param slab - The slab.
+ * @param slot - The number of the slot.
+ * @return the game, which stays at the same address until released.
+ */
+struct Game *slab_at(GameSlab *slab, int slot) {
+    pthread_mutex_lock(&slab->lock);
+    struct Game *game = &get_slot(slab, slot)->game;
+    pthread_mutex_unlock(&slab->lock);
+    return game;
+}
+
+/**
+ * Gets the arena of a slot which is known to be in use.
+ * @param slab - The slab.
+ * @param slot - The number of the slot.
+ * @return the arena, which is reset when the slot is released.
+ */
+Arena *slab_arena(GameSlab *slab, int slot) {
+    pthread_mutex_lock(&slab->lock);
+    Arena *arena = &get_slot(slab, slot)->arena;
+    pthread_mutex_unlock(&slab->lock);
+    return arena;
+}
+
+/**
+ * Gets the amount of slots which are in use.
+ * @param slab - The slab.
+ * @return the amount of slots.
+ */
+int slab_in_use(GameSlab *slab) {
+    pthread_mutex_lock(&slab->lock);
+    int inUse = slab->inUseCount;
+    pthread_mutex_unlock(&slab->lock);
+    return inUse;
+}
+
+/**
+ * Gets the amount of memory taken by the slots of a slab, not counting
+ * their arenas.
+ * @param slab - The slab.
+ * @return the amount of bytes.
+ */
+size_t slab_bytes(GameSlab *slab) {
+    pthread_mutex_lock(&slab->lock);
+    size_t bytes = sizeof(GameSlot) * slab->slotCount;
+    pthread_mutex_unlock(&slab->lock);
+    return bytes;
+}
+
+/**
+ * Gets the current generation of a slot.
+ * @param slab - The slab.
+ * @param slot - The number of the slot.
+ * @return the generation.
+ */
+unsigned int slab_generation(GameSlab *slab, int slot) {
+    pthread_mutex_lock(&slab->lock);
+    unsigned int generation = get_slot(slab, slot)->generation;
+    pthread_mutex_unlock(&slab->lock);
+    return generation;
+}
+
+/**
+ * Gets the game stored in a slot, checking it is still the same game.
+ * @param slab - The slab.
+ * @param slot - The number of the slot.
+ * @param generation - The generation the slot had when the game was stored.
+ * @return the game, NULL if the slot has been released since.
+ */
+struct Game *slab_get(GameSlab *slab, int slot, unsigned int generation) {
+    struct Game *game = NULL;
+    pthread_mutex_lock(&slab->lock);
+    if (slot >= 0 && slot < slab->slotCount) {
+        GameSlot *gameSlot = get_slot(slab, slot);
+        if (gameSlot->inUse && gameSlot->generation == generation) {
+            game = &gameSlot->game;
+        }
+    }
+    pthread_mutex_unlock(&slab->lock);
+    return game;
+}
+
+/**
+ * Returns a slot to the slab, freeing everything allocated from its arena
+ * at once. Anything else held by the game must already be freed.
+ * @param slab - The slab.
+ * @param slot - The number of the slot.
+ */
+void slab_release(GameSlab *slab, int slot) {
+    pthread_mutex_lock(&slab->lock);
+    GameSlot *gameSlot = get_slot(slab, slot);
+    arena_reset(&gameSlot->arena);
+    gameSlot->inUse = 0;
+    gameSlot->generation++;
+    gameSlot->nextFree = slab->freeSlot;
+    slab->freeSlot = slot;
+    slab->inUseCount--;
+    pthread_mutex_unlock(&slab->lock);
+}
@@ -0,0 +1,51 @@
+#ifndef SLAB_H
+#define SLAB_H
+
+#include "shared.h"
+#include "arena.h"
+
+#define SLAB_CHUNK_SIZE 64
+
+/**
+ * Type defination for one slot of a game slab. The generation is bumped
+ * every time the slot is released, so stale references can be detected.
+ * The arena holds everything the game allocates, and is reset when the
+ * slot is released so the next game in the slot reuses its memory.
+ */
+typedef struct {
+    struct Game game;
+    Arena arena;
+    unsigned int generation;
+    int inUse;
+    int nextFree;
+} GameSlot;
+
+/**
+ * Type defination for storage of game instances. Slots are allocated in
+ * chunks which never move, so a game keeps its address for as long as it
+ * is in use, and released slots are reused before the slab grows.
+ */
+typedef struct {
+    pthread_mutex_t lock;
+    int slotCount;
+    int inUseCount;
+    int freeSlot;
+    size_t arenaSize;
+    GameSlot **chunks;
+} GameSlab;
+
+/**
+ * Function prototypes.
+ */
+void slab_init(GameSlab *slab, size_t arenaSize);
+void slab_free(GameSlab *slab);
+int slab_alloc(GameSlab *slab);
+struct Game *slab_at(GameSlab *slab, int slot);
+Arena *slab_arena(GameSlab *slab, int slot);
+int slab_in_use(GameSlab *slab);
+size_t slab_bytes(GameSlab *slab);
+unsigned int slab_generation(GameSlab *slab, int slot);
+struct Game *slab_get(GameSlab *slab, int slot, unsigned int generation);
+void slab_release(GameSlab *slab, int slot);
+
+#endif
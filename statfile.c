@@ -0,0 +1,125 @@
+#include "statfile.h"
+
+/**
+ * Check and validates one line of the statfile
+ * @param line - The string to check.
+ * @returns 1 if the line is valid.
+ */
+int check_stat_line(char *line) {
+    char *newLine = malloc(strlen(line) + 1);
+    strcpy(newLine, line);
+    newLine[strlen(line)] = '\0';
+    if (!match_seperators(newLine, 0, EXPECTED_STATFILE_SEP)) {
+        free(newLine);
+        return 0;
+    }
+    int isValid = 1;
+    char **commaSplit = split(newLine, ",");
+    for (int i = 0; i < EXPECTED_STATFILE_SEP + 1; i++) {
+        if (!is_string_digit(commaSplit[i]) ||
+                strcmp(commaSplit[i], "") == 0) {
+            isValid = 0;
+            break;
+        }
+    }
+    free(commaSplit);
+    free(newLine);
+    return isValid;
+}
+
+/**
+ * Generates one stat property from a statfile line.
+ * @param line - The line to generate from.
+ * @returns one entry to the statfile property.
+ */
+Stat generate_stat(char *line) {
+    Stat stat;
+    char **contentSplit = split(line, ",");
+    stat.port = malloc(strlen(contentSplit[PORT]) + 1);
+    strcpy(stat.port, contentSplit[PORT]);
+    stat.port[strlen(contentSplit[PORT])] = '\0';
+    stat.tokens = atoi(contentSplit[START_TOKENS]);
+    stat.points = atoi(contentSplit[START_POINTS]);
+    stat.players = atoi(contentSplit[START_PLAYERS]);
+    free(contentSplit);
+    return stat;
+}
+
+/**
+ * Gets the index of an non zero port.
+ * @param prop - Statfile properties
+ * @returns index of the port, -1 if the port is not in the property.
+ */
+int index_of_non_zero_port(StatFileProp prop, char *port) {
+    int index = -1;
+    if (strcmp(port, "0") == 0) {
+        return -1;
+    }
+    for (int i = 0; i < prop.amount; i++) {
+        if (strcmp(prop.stats[i].port, port) == 0) {
+            index = i;
+            break;
+        }
+    }
+    return index;
+}
+
+/**
+ * Reads a statfile.
+ * @param path - The path to the statfile.
+ * @param output - Loaded with values from the statfile.
+ * @returns 0 on success, -1 if the statfile is invalid.
+ */
+int read_statfile(char *path, StatFileProp *output) {
+    StatFileProp prop;
+    prop.stats = NULL;
+    FILE *file = fopen(path, "r");
+    if (file == NULL || !file) {
+        return -1;
+    }
+    char *content = malloc(sizeof(char)), character;
+    int counter = 0, lines = 0, isValid = 1;
+    while((character = getc(file)) != EOF) {
+        content = realloc(content, sizeof(char) * (counter + 1));
+        content[counter++] = character;
+        if (character == '\n') {
+            lines++;
+        }
+    }
+    content = realloc(content, sizeof(char) * (counter + 1));
+    content[counter] = '\0';
+    if (lines == 0 && check_stat_line(content)) {
+        prop.stats = malloc(sizeof(Stat));
+        prop.stats[0] = generate_stat(content);
+        prop.amount = 1;
+    } else if (lines > 0) {
+        char **splitContent = split(content, "\n");
+        prop.stats = malloc(sizeof(Stat) * (lines + 1));
+        prop.amount = 0;
+        for (int i = 0; i < lines; i++) {
+            if (check_stat_line(splitContent[i])) {
+                Stat stat = generate_stat(splitContent[i]);
+                if (index_of_non_zero_port(prop, stat.port) != -1) {
+                    isValid = 0;
+                    break;
+                }
+                prop.stats[i] = stat;
+                prop.amount++;
+            } else {
+                isValid = 0;
+                break;
+            }
+        }
+        free(splitContent);
+    } else {
+        isValid = 0;
+    }
+    fclose(file);
+    free(content);
+    if (!isValid) {
+        free(prop.stats);
+        return -1;
+    }
+    *output = prop;
+    return 0;
+}
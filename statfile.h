@@ -0,0 +1,44 @@
+#ifndef STATFILE_H
+#define STATFILE_H
+
+#include "shared.h"
+
+#define EXPECTED_STATFILE_SEP 3
+
+/**
+ * Enum for statfile indexes.
+ */
+enum StatFile {
+    PORT = 0,
+    START_TOKENS = 1,
+    START_POINTS = 2,
+    START_PLAYERS = 3,
+};
+
+/**
+ * Type defination one entry of a statfile.
+ */
+typedef struct {
+    char *port;
+    int tokens;
+    int points;
+    int players;
+} Stat;
+
+/**
+ * Type defination for properties of a statfile.
+ */
+typedef struct {
+    int amount;
+    Stat *stats;
+} StatFileProp;
+
+/**
+ * Function prototypes.
+ */
+int check_stat_line(char *line);
+Stat generate_stat(char *line);
+int index_of_non_zero_port(StatFileProp prop, char *port);
+int read_statfile(char *path, StatFileProp *output);
+
+#endif
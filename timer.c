@@ -0,0 +1,171 @@
+#include <stdlib.h>
+#include <time.h>
+#include "timer.h"
+
+/**
+ * Gets the current time in ticks of a monotonic clock.
+ * @return the number of ticks since an arbitrary point.
+ */
+uint64_t timer_now(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t) now.tv_sec * 1000 + now.tv_nsec / 1000000) /
+            TIMER_TICK_MS;
+}
+
+/**
+ * Sets up a timer which is not armed.
+ * @param timer - The timer to setup.
+ * @param handler - Called when the timer expires.
+ * @param data - Arbitrary data for the handler.
+ */
+void timer_init(Timer *timer, TimerHandler handler, void *data) {
+    timer->next = NULL;
+    timer->prev = NULL;
+    timer->expires = 0;
+    timer->handler = handler;
+    timer->data = data;
+}
+
+/**
+ * Checks if a timer is currently armed.
+ * @param timer - The timer to check.
+ * @return 1 if the timer is on a wheel.
+ */
+int timer_is_armed(Timer *timer) {
+    return timer->prev != NULL;
+}
+
+/**
+ * Sets up an empty timer wheel starting at the current time.
+ * @param wheel - The wheel to setup.
+ */
+void timer_wheel_init(TimerWheel *wheel) {
+    wheel->now = timer_now();
+    wheel->count = 0;
+    for (int level = 0; level < WHEEL_LEVELS; level++) {
+        for (int slot = 0; slot < WHEEL_SLOTS; slot++) {
+            wheel->slots[level][slot] = NULL;
+        }
+    }
+}
+
+/**
+ * Links a timer in to the slot matching its expiry tick.
+ * @param wheel - The wheel to link in to.
+ * @param timer - The timer, with its expiry tick set.
+ */
+static void link_timer(TimerWheel *wheel, Timer *timer) {
+    uint64_t maxDelta = ((uint64_t) 1 << (WHEEL_BITS * WHEEL_LEVELS)) - 1;
+    uint64_t delta = timer->expires > wheel->now ?
+            timer->expires - wheel->now : 0;
+    if (delta > maxDelta) {
+        delta = maxDelta;
+        timer->expires = wheel->now + maxDelta;
+    }
+    int level = 0;
+    while (level < WHEEL_LEVELS - 1 &&
+            delta >= (uint64_t) 1 << (WHEEL_BITS * (level + 1))) {
+        level++;
+    }
+    int slot = (timer->expires >> (WHEEL_BITS * level)) & (WHEEL_SLOTS - 1);
+    Timer **head = &wheel->slots[level][slot];
+    timer->next = *head;
+    if (*head != NULL) {
+        (*head)->prev = &timer->next;
+    }
+    timer->prev = head;
+    *head = timer;
+}
+
+/**
+ * Unlinks a timer from whichever slot holds it.
+ * @param timer - The armed timer.
+ */
+static void unlink_timer(Timer *timer) {
+    *timer->prev = timer->next;
+    if (timer->next != NULL) {
+        timer->next->prev = timer->prev;
+    }
+    timer->next = NULL;
+    timer->prev = NULL;
+}
+
+/**
+ * Arms a timer, replacing any expiry it already had.
+ * @param wheel - The wheel to arm the timer on.
+ * @param timer - The timer to arm.
+ * @param milliseconds - How long until the timer expires.
+ */
+void timer_wheel_add(TimerWheel *wheel, Timer *timer, int milliseconds) {
+    timer_wheel_cancel(wheel, timer);
+    // An empty wheel is not advanced, so catch it up before measuring.
+    if (wheel->count == 0) {
+        wheel->now = timer_now();
+    }
+    uint64_t ticks = (milliseconds + TIMER_TICK_MS - 1) / TIMER_TICK_MS;
+    timer->expires = wheel->now + (ticks > 0 ? ticks : 1);
+    link_timer(wheel, timer);
+    wheel->count++;
+}
+
+/**
+ * Disarms a timer. Does nothing if the timer is not armed.
+ * @param wheel - The wheel the timer is armed on.
+ * @param timer - The timer to disarm.
+ */
+void timer_wheel_cancel(TimerWheel *wheel, Timer *timer) {
+    if (!timer_is_armed(timer)) {
+        return;
+    }
+    unlink_timer(timer);
+    wheel->count--;
+}
+
+/**
+ * Moves every timer in a slot of an upper level down to the levels below.
+ * @param wheel - The wheel to cascade.
+ * @param level - The level to take timers from.
+ * @return 1 if the slot taken from was the first of its level, meaning the
+ * next level up is also due to cascade.
+ */
+static int cascade(TimerWheel *wheel, int level) {
+    int slot = (wheel->now >> (WHEEL_BITS * level)) & (WHEEL_SLOTS - 1);
+    Timer *timer = wheel->slots[level][slot];
+    wheel->slots[level][slot] = NULL;
+    while (timer != NULL) {
+        Timer *next = timer->next;
+        link_timer(wheel, timer);
+        timer = next;
+    }
+    return slot == 0;
+}
+
+/**
+ * Moves the wheel up to the current time, running the handler of every
+ * timer which expires along the way. Handlers may arm or cancel any timer.
+ * @param wheel - The wheel to advance.
+ * @param context - Given to each handler.
+ */
+void timer_wheel_advance(TimerWheel *wheel, void *context) {
+    uint64_t now = timer_now();
+    while (wheel->now < now) {
+        wheel->now++;
+        int slot = wheel->now & (WHEEL_SLOTS - 1);
+        if (slot == 0) {
+            int level = 1;
+            while (level < WHEEL_LEVELS && cascade(wheel, level)) {
+                level++;
+            }
+        }
+        while (wheel->slots[0][slot] != NULL) {
+            Timer *timer = wheel->slots[0][slot];
+            unlink_timer(timer);
+            wheel->count--;
+            timer->handler(context, timer);
+        }
+        if (wheel->count == 0) {
+            wheel->now = now;
+        }
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef TIMER_H
+#define TIMER_H
+
+#include <stdint.h>
+
+#define TIMER_TICK_MS 100
+#define WHEEL_BITS 6
+#define WHEEL_SLOTS (1 << WHEEL_BITS)
+#define WHEEL_LEVELS 4
+
+typedef struct Timer Timer;
+
+/**
+ * Callback for a timer which has expired. The context is whatever was
+ * given to timer_wheel_advance.
+ */
+typedef void (*TimerHandler)(void *context, Timer *timer);
+
+/**
+ * Type defination for a timer which can be armed on a timer wheel. Timers
+ * are embedded in whatever they time out, so arming never allocates.
+ */
+struct Timer {
+    Timer *next;
+    Timer **prev;
+    uint64_t expires;
+    TimerHandler handler;
+    void *data;
+};
+
+/**
+ * Type defination for a hierarchical timer wheel. Each level has
+ * WHEEL_SLOTS slots, and each slot of a level covers a whole turn of the
+ * level below it. Timers are moved down a level as their slot comes around.
+ */
+typedef struct {
+    uint64_t now;
+    int count;
+    Timer *slots[WHEEL_LEVELS][WHEEL_SLOTS];
+} TimerWheel;
+
+/**
+ * Function prototypes.
+ */
+uint64_t timer_now(void);
+void timer_init(Timer *timer, TimerHandler handler, void *data);
+int timer_is_armed(Timer *timer);
+void timer_wheel_init(TimerWheel *wheel);
+void timer_wheel_add(TimerWheel *wheel, Timer *timer, int milliseconds);
+void timer_wheel_cancel(TimerWheel *wheel, Timer *timer);
+void timer_wheel_advance(TimerWheel *wheel, void *context);
+
+#endif
@@ -0,0 +1,50 @@
+#include "timon.h"
+
+/**
+ * Exits the program with a error.
+ * @param int - Error code.
+ */
+void exit_with_error(int error) {
+    switch(error) {
+        case INVALID_ARG_NUM:
+            fprintf(stderr, "Usage: timon deckfile imagefile\n");
+            break;
+        case INVALID_DECKFILE:
+            fprintf(stderr, "Bad deckfile\n");
+            break;
+        case SYSTEM_ERR:
+            fprintf(stderr, "System error\n");
+            break;
+    }
+    exit(error);
+}
+
+/**
+ * Checks initial arguments for timon.
+ * @param argc - Argument count.
+ * @param argv - Argument vector.
+ */
+void check_args(int argc, char **argv) {
+    if (argc != EXPECTED_ARGC) {
+        exit_with_error(INVALID_ARG_NUM);
+    }
+}
+
+/**
+ * Main. Compiles a deckfile in to a deck image, which rafiki maps instead
+ * of parsing when given it as its deckfile.
+ */
+int main(int argc, char **argv) {
+    check_args(argc, argv);
+    int deckSize;
+    struct Card *deck;
+    if (parse_deck_file(&deckSize, &deck, argv[DECKFILE]) != VALID) {
+        exit_with_error(INVALID_DECKFILE);
+    }
+    if (deck_image_write(argv[IMAGEFILE], deck, deckSize) == -1) {
+        free(deck);
+        exit_with_error(SYSTEM_ERR);
+    }
+    free(deck);
+    return 0;
+}
@@ -0,0 +1,23 @@
+#ifndef TIMON_H
+#define TIMON_H
+
+#include "shared.h"
+#include "decks.h"
+
+#define EXPECTED_ARGC 3
+
+/**
+ * Enum for timon arguments.
+ */
+enum Argument {
+    DECKFILE = 1,
+    IMAGEFILE = 2
+};
+
+/**
+ * Function prototypes.
+ */
+void exit_with_error(int error);
+void check_args(int argc, char **argv);
+
+#endif
@@ -0,0 +1,191 @@
+#include "uring.h"
+
+/**
+ * Maps one of the rings shared with the kernel.
+ * @param fd - The io_uring file descriptor.
+ * @param size - The size of the mapping.
+ * @param offset - Which ring to map.
+ * @return the mapping, NULL on failure.
+ */
+static void *map_ring(int fd, size_t size, off_t offset) {
+    void *ring = mmap(NULL, size, PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE, fd, offset);
+    return ring == MAP_FAILED ? NULL : ring;
+}
+
+/**
+ * Sets up an io_uring instance. Fails unless the kernel can wait for
+ * completions with a timeout and never drops completions.
+ * @param ring - The ring to setup.
+ * @param entries - The size of the submission ring.
+ * @return 0 on success, -1 if io_uring is not available.
+ */
+int uring_init(Uring *ring, unsigned int entries) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    memset(ring, 0, sizeof(Uring));
+    // Every socket may have a receive and a send in flight at once.
+    params.flags = IORING_SETUP_CQSIZE;
+    params.cq_entries = entries * 16;
+    ring->fd = syscall(__NR_io_uring_setup, entries, &params);
+    if (ring->fd == -1) {
+        return -1;
+    }
+    if (!(params.features & IORING_FEAT_EXT_ARG) ||
+            !(params.features & IORING_FEAT_NODROP)) {
+        close(ring->fd);
+        return -1;
+    }
+    ring->sqRingSize = params.sq_off.array +
+            params.sq_entries * sizeof(unsigned int);
+    ring->cqRingSize = params.cq_off.cqes +
+            params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        ring->sqRingSize = max(ring->sqRingSize, ring->cqRingSize);
+    }
+    ring->sqRing = map_ring(ring->fd, ring->sqRingSize, IORING_OFF_SQ_RING);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        ring->cqRing = ring->sqRing;
+    } else if (ring->sqRing != NULL) {
+        ring->cqRing = map_ring(ring->fd, ring->cqRingSize,
+                IORING_OFF_CQ_RING);
+    }
+    ring->sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = map_ring(ring->fd, ring->sqesSize, IORING_OFF_SQES);
+    if (ring->sqRing == NULL || ring->cqRing == NULL || ring->sqes == NULL) {
+        uring_free(ring);
+        return -1;
+    }
+    char *sq = ring->sqRing;
+    ring->sqHead = (unsigned int *) (sq + params.sq_off.head);
+    ring->sqTail = (unsigned int *) (sq + params.sq_off.tail);
+    ring->sqMask = *(unsigned int *) (sq + params.sq_off.ring_mask);
+    ring->sqEntries = params.sq_entries;
+    ring->sqLocalTail = *ring->sqTail;
+    // Entries are always submitted in order, so slot i holds entry i.
+    unsigned int *array = (unsigned int *) (sq + params.sq_off.array);
+    for (unsigned int i = 0; i < params.sq_entries; i++) {
+        array[i] = i;
+    }
+    char *cq = ring->cqRing;
+    ring->cqHead = (unsigned int *) (cq + params.cq_off.head);
+    ring->cqTail = (unsigned int *) (cq + params.cq_off.tail);
+    ring->cqMask = *(unsigned int *) (cq + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *) (cq + params.cq_off.cqes);
+    return 0;
+}
+
+/**
+ * Frees an io_uring instance. Anything still in flight is cancelled by the
+ * kernel.
+ * @param ring - The ring to free.
+ */
+void uring_free(Uring *ring) {
+    if (ring->sqes != NULL) {
+        munmap(ring->sqes, ring->sqesSize);
+    }
+    if (ring->cqRing != NULL && ring->cqRing != ring->sqRing) {
+        munmap(ring->cqRing, ring->cqRingSize);
+    }
+    if (ring->sqRing != NULL) {
+        munmap(ring->sqRing, ring->sqRingSize);
+    }
+    close(ring->fd);
+}
+
+/**
+ * Hands every prepared entry to the kernel and optionally waits for at
+ * least one completion.
+ * @param ring - The ring to submit on.
+ * @param wait - 1 to wait for a completion.
+ * @param milliseconds - The longest time to wait, -1 to wait forever.
+ * @return 0 on success, -1 on failure.
+ */
+static int enter(Uring *ring, int wait, int milliseconds) {
+    unsigned int submitted = ring->sqLocalTail -
+            __atomic_load_n(ring->sqHead, __ATOMIC_ACQUIRE);
+    if (!wait && submitted == 0) {
+        return 0;
+    }
+    __atomic_store_n(ring->sqTail, ring->sqLocalTail, __ATOMIC_RELEASE);
+    struct __kernel_timespec timeout;
+    struct io_uring_getevents_arg arg;
+    memset(&arg, 0, sizeof(arg));
+    unsigned int flags = wait ? IORING_ENTER_GETEVENTS : 0;
+    void *argPointer = NULL;
+    size_t argSize = 0;
+    if (wait && milliseconds >= 0) {
+        timeout.tv_sec = milliseconds / 1000;
+        timeout.tv_nsec = (milliseconds % 1000) * 1000000L;
+        arg.ts = (unsigned long) &timeout;
+        flags |= IORING_ENTER_EXT_ARG;
+        argPointer = &arg;
+        argSize = sizeof(arg);
+    }
+    int result = syscall(__NR_io_uring_enter, ring->fd, submitted,
+            wait ? 1 : 0, flags, argPointer, argSize);
+    if (result == -1 && errno != ETIME && errno != EINTR) {
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Gets a blank submission entry, submitting what has already been prepared
+ * if the ring is full.
+ * @param ring - The ring to prepare on.
+ * @return the entry, which is submitted by the next uring_submit.
+ */
+struct io_uring_sqe *uring_get_sqe(Uring *ring) {
+    unsigned int head = __atomic_load_n(ring->sqHead, __ATOMIC_ACQUIRE);
+    while (ring->sqLocalTail - head == ring->sqEntries) {
+        enter(ring, 0, 0);
+        head = __atomic_load_n(ring->sqHead, __ATOMIC_ACQUIRE);
+    }
+    struct io_uring_sqe *sqe = &ring->sqes[ring->sqLocalTail & ring->sqMask];
+    ring->sqLocalTail++;
+    memset(sqe, 0, sizeof(struct io_uring_sqe));
+    return sqe;
+}
+
+/**
+ * Submits every prepared entry and waits for a completion, in one system
+ * call. Returns straight away if completions are already waiting.
+ * @param ring - The ring to submit on.
+ * @param milliseconds - The longest time to wait, -1 to wait forever.
+ * @return 0 on success, -1 on failure.
+ */
+int uring_submit(Uring *ring, int milliseconds) {
+    int waiting = uring_peek(ring) != NULL;
+    return enter(ring, !waiting, milliseconds);
+}
+
+/**
+ * Submits every prepared entry without waiting.
+ * @param ring - The ring to submit on.
+ * @return 0 on success, -1 on failure.
+ */
+int uring_flush(Uring *ring) {
+    return enter(ring, 0, 0);
+}
+
+/**
+ * Gets the oldest completion which has not been handled.
+ * @param ring - The ring to take from.
+ * @return the completion, NULL if there are none.
+ */
+struct io_uring_cqe *uring_peek(Uring *ring) {
+    unsigned int head = *ring->cqHead;
+    if (head == __atomic_load_n(ring->cqTail, __ATOMIC_ACQUIRE)) {
+        return NULL;
+    }
+    return &ring->cqes[head & ring->cqMask];
+}
+
+/**
+ * Marks the oldest completion as handled, freeing its slot.
+ * @param ring - The ring to advance.
+ */
+void uring_advance(Uring *ring) {
+    __atomic_store_n(ring->cqHead, *ring->cqHead + 1, __ATOMIC_RELEASE);
+}
@@ -0,0 +1,44 @@
+#ifndef URING_H
+#define URING_H
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include "shared.h"
+
+/**
+ * Type defination for an io_uring instance driven through the raw system
+ * calls. Entries are prepared in the submission ring and handed to the
+ * kernel in a single io_uring_enter along with the wait for completions.
+ */
+typedef struct {
+    int fd;
+    unsigned int *sqHead;
+    unsigned int *sqTail;
+    unsigned int sqMask;
+    unsigned int sqEntries;
+    unsigned int sqLocalTail;
+    struct io_uring_sqe *sqes;
+    unsigned int *cqHead;
+    unsigned int *cqTail;
+    unsigned int cqMask;
+    struct io_uring_cqe *cqes;
+    void *sqRing;
+    size_t sqRingSize;
+    void *cqRing;
+    size_t cqRingSize;
+    size_t sqesSize;
+} Uring;
+
+/**
+ * Function prototypes.
+ */
+int uring_init(Uring *ring, unsigned int entries);
+void uring_free(Uring *ring);
+struct io_uring_sqe *uring_get_sqe(Uring *ring);
+int uring_submit(Uring *ring, int milliseconds);
+int uring_flush(Uring *ring);
+struct io_uring_cqe *uring_peek(Uring *ring);
+void uring_advance(Uring *ring);
+
+#endif
@@ -125,13 +125,14 @@ enum Error get_socket(int *output, char *port) {
 }
 
 /**
- * Listens on the server for any bytes.
- * @param out - The file descriptor to listen on.
- * @param output - The stream of data received.
+ * Listens on the server for the next line.
+ * @param out - The reader of the server's connection.
+ * @param output - Set to the line, valid until the next read. NULL if the
+ * server closed the connection.
  */
-void listen_server(FILE *out, char **output) {
-    read_line(out, output, 0);
-    if (*output == NULL) {
+void listen_server(LineReader *out, char **output) {
+    if (line_reader_read(out, output) == -1) {
+        *output = NULL;
         return;
     }
     if (strcmp(*output, "eog") == 0) {
@@ -183,7 +184,6 @@ void parse_playinfo_message(Server *server, char *buffer) {
     display_turn_info(&server->game);
     free(playInfo);
     free(splitString);
-    free(buffer);
 }
 
 /**
@@ -201,7 +201,6 @@ int handle_tokens_message(Server *server, char *buffer) {
         server->game.tokenCount[i] = output;
     }
     display_turn_info(&server->game);
-    free(buffer);
     return 1;
 }
 
@@ -211,39 +210,32 @@ int handle_tokens_message(Server *server, char *buffer) {
  */
 enum Error get_game_info(Server *server) {
     char *buffer;
-    listen_server(server->out, &buffer);
+    listen_server(&server->out, &buffer);
     if (buffer == NULL) {
-        free(buffer);
         return COMM_ERR;
     }
     if (strstr(buffer, "rid") != NULL) {
         if (!verify_rid(buffer)) {
-            free(buffer);
             return COMM_ERR;
         }
         char **splitString = split(buffer, "d");
         printf("%s\n", splitString[RIGHT]);
         free(splitString);
-        free(buffer);
     } else {
-        free(buffer);
         return COMM_ERR;
     }
-    listen_server(server->out, &buffer);
-    if (strstr(buffer, "playinfo") != NULL) {
+    listen_server(&server->out, &buffer);
+    if (buffer != NULL && strstr(buffer, "playinfo") != NULL) {
         parse_playinfo_message(server, buffer);
     } else {
-        free(buffer);
         return COMM_ERR;
     }
-    listen_server(server->out, &buffer);
-    if (strstr(buffer, "tokens") != NULL) {
+    listen_server(&server->out, &buffer);
+    if (buffer != NULL && strstr(buffer, "tokens") != NULL) {
         if (!handle_tokens_message(server, buffer)) {
-            free(buffer);
             return INVALID_MESSAGE;
         };
     } else {
-        free(buffer);
         return COMM_ERR;
     }
     return NOTHING_WRONG;
@@ -263,28 +255,113 @@ enum Error connect_server(Server *server, char *gamename, char *playername) {
         return err;
     }
     server->in = fdopen(server->socket, "w");
-    server->out = fdopen(server->socket, "r");
+    line_reader_init(&server->out, server->socket);
     send_message(server->in, "play%s\n", server->key);
     char *buffer;
-    read_line(server->out, &buffer, 0);
-    if (strcmp(buffer, "yes") != 0) {
-        free(buffer);
+    if (line_reader_read(&server->out, &buffer) == -1 ||
+            strcmp(buffer, "yes") != 0) {
         return BAD_AUTH;
     }
     send_message(server->in, "%s\n", gamename);
     send_message(server->in, "%s\n", playername);
     server->gameName = gamename;
-    free(buffer);
     return NOTHING_WRONG;
 }
 
 /**
- * Parses the player message from the hub.
+ * Reads a list of integers seperated by commas from a message.
+ * @param cursor - The position in the message, moved to the character after
+ * the list.
+ * @param values - Where to store the integers.
+ * @param count - The amount of integers expected.
+ * @return 1 if the list held enough integers.
+ */
+int read_list(char **cursor, int *values, int count) {
+    for (int i = 0; i < count; i++) {
+        if (i > 0 && *(*cursor)++ != ',') {
+            return 0;
+        }
+        char *end;
+        values[i] = strtol(*cursor, &end, 10);
+        if (end == *cursor) {
+            return 0;
+        }
+        *cursor = end;
+    }
+    return 1;
+}
+
+/**
+ * Reads the cards on the board from a snapshot message.
+ * @param game - The game state to fill.
+ * @param cursor - The position in the message, moved to the end of the
+ * board.
+ * @return 1 if every card was valid.
+ */
+int read_snapshot_board(struct GameState *game, char **cursor) {
+    const char *tokens = "PBYR";
+    game->boardSize = 0;
+    while (**cursor != '|') {
+        if (game->boardSize == BOARD_SIZE ||
+                (game->boardSize > 0 && *(*cursor)++ != ';')) {
+            return 0;
+        }
+        char *token = strchr(tokens, **cursor);
+        if (**cursor == '\0' || token == NULL) {
+            return 0;
+        }
+        struct Card *card = &game->board[game->boardSize++];
+        card->discount = token - tokens;
+        (*cursor)++;
+        if (*(*cursor)++ != ':' || !read_list(cursor, &card->points, 1) ||
+                *(*cursor)++ != ':' ||
+                !read_list(cursor, card->cost, TOKEN_MAX - 1)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * Parses the snapshot message sent by the hub on reconnect, filling the
+ * whole game state in one pass.
  * @param server - The server instance.
  * @param line - The line to parse.
+ * @return 1 if the message was valid.
  */
-void parse_player_message(Server *server, char *line) {
-
+int parse_snapshot_message(Server *server, char *line) {
+    struct GameState *game = &server->game;
+    char *cursor = line + strlen("snapshot");
+    if (*cursor == '\0') {
+        return 0;
+    }
+    int selfId = *cursor++ - 'A';
+    int count;
+    if (*cursor++ != '/' || !read_list(&cursor, &count, 1) ||
+            count < MIN_PLAYERS || count > MAX_PLAYERS || selfId < 0 ||
+            selfId >= count || *cursor++ != '|') {
+        return 0;
+    }
+    game->selfId = selfId;
+    game->playerCount = count;
+    setup_players(server, count);
+    if (!read_list(&cursor, game->tokenCount, TOKEN_MAX - 1) ||
+            *cursor++ != '|' || !read_snapshot_board(game, &cursor)) {
+        return 0;
+    }
+    cursor++;
+    for (int i = 0; i < count; i++) {
+        struct Player *player = &game->players[i];
+        if ((i > 0 && *cursor++ != ';') ||
+                !read_list(&cursor, &player->score, 1) ||
+                *cursor++ != ':' ||
+                !read_list(&cursor, player->discounts, TOKEN_MAX - 1) ||
+                *cursor++ != ':' ||
+                !read_list(&cursor, player->tokens, TOKEN_MAX)) {
+            return 0;
+        }
+    }
+    return *cursor == '\0';
 }
 
 /**
@@ -298,32 +375,20 @@ enum Error reconnect_server(Server *server, char *rid) {
         return err;
     }
     server->in = fdopen(server->socket, "w");
-    server->out = fdopen(server->socket, "r");
+    line_reader_init(&server->out, server->socket);
     send_message(server->in, "reconnect%s\n", server->key);
     char *buffer;
-    read_line(server->out, &buffer, 0);
-    if (strcmp(buffer, "yes") != 0) {
-        free(buffer);
+    if (line_reader_read(&server->out, &buffer) == -1 ||
+            strcmp(buffer, "yes") != 0) {
         return BAD_AUTH;
     }
     send_message(server->in, "rid%s\n", rid);
-    read_line(server->out, &buffer, 0);
-    if (strcmp(buffer, "player") != 0) {
-        free(buffer);
+    if (line_reader_read(&server->out, &buffer) == -1 ||
+            strstr(buffer, "snapshot") != buffer ||
+            !parse_snapshot_message(server, buffer)) {
         return COMM_ERR;
     }
-    while (1) {
-        read_line(server->out, &buffer, 0);
-        if (strstr(buffer, "newcard") != NULL) {
-            handle_new_card_message(&server->game, buffer);
-            free(buffer);
-        } else {
-            free(buffer);
-            break;
-        }
-    }
-    // parse_player_message(server, buffer);
-    free(buffer);
+    display_turn_info(&server->game);
     return NOTHING_WRONG;
 }
 
@@ -334,7 +399,6 @@ void free_server(Server server) {
     free(server.game.players);
     free(server.key);
     fclose(server.in);
-    fclose(server.out);
 }
 
 /**
@@ -468,7 +532,6 @@ enum Error handle_messages(Server *server, enum MessageFromHub type,
             if (err) {
                 err = COMM_ERR;
             } else {
-                free(line);
                 exit_with_error(PLAYER_DISCONNECTED, id + 'A');
             }
         case INVALID:
@@ -476,7 +539,6 @@ enum Error handle_messages(Server *server, enum MessageFromHub type,
             if (err) {
                 err = COMM_ERR;
             } else {
-                free(line);
                 exit_with_error(INVALID_MESSAGE, id + 'A');
             }
         default:
@@ -493,15 +555,13 @@ enum Error play_game(Server *server) {
     enum ErrorCode err = 0;
     while (1) {
         char *line;
-        int readBytes = read_line(server->out, &line, 0);
+        int readBytes = line_reader_read(&server->out, &line);
         // printf("recieved from server: %s\n", line);
         if (readBytes <= 0) {
-            free(line);
             return COMM_ERR;
         }
         enum MessageFromHub type = classify_from_hub(line);
         err = handle_messages(server, type, line);
-        free(line);
         if (err) {
             return err;
         } else if (type != DO_WHAT) {
@@ -33,7 +33,7 @@ typedef struct {
     char *gameName;
     char *key;
     FILE *in;
-    FILE *out;
+    LineReader out;
     struct GameState game;
 } Server;
 
@@ -45,7 +45,10 @@ int is_newline_or_comma(char character);
 void check_args(int argc, char **argv);
 enum Error get_socket(int *output, char *port);
 int verify_rid(char *line);
-void listen_server(FILE *out, char **output);
+int read_list(char **cursor, int *values, int count);
+int read_snapshot_board(struct GameState *game, char **cursor);
+int parse_snapshot_message(Server *server, char *line);
+void listen_server(LineReader *out, char **output);
 enum Error get_game_info(Server *server);
 enum Error connect_server(Server *server, char *gamename, char *playername);
 void free_server(Server server);